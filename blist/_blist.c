@@ -37,6 +37,10 @@
 
 #include <Python.h>
 #include <stddef.h>
+#include <math.h>
+#ifdef WITH_THREAD
+#include "pythread.h"
+#endif
 
 #if !defined(__STDC_VERSION__) || __STDC_VERSION__ < 199901L
 #define restrict
@@ -113,6 +117,9 @@
 #define PyVarObject_HEAD_INIT(type, size)       \
         PyObject_HEAD_INIT(type) size,
 #define PyUnicode_FromFormat PyString_FromFormat
+#define PyBytes_Type PyString_Type
+#define PyBytes_GET_SIZE PyString_GET_SIZE
+#define PyBytes_AS_STRING PyString_AS_STRING
 #endif
 
 #elif PY_MAJOR_VERSION == 3
@@ -124,6 +131,36 @@
 #define PyInt_FromLong PyLong_FromLong
 #endif
 
+/* Sorting strings and big ints by radix needs 64-bit digits */
+#if defined(HAVE_UINT64_T) || defined(PY_UINT64_T)
+#define BLIST_WIDE_RADIX_SORT 1
+#endif
+
+/* Iteration prefetches the item BLIST_PREFETCH_DISTANCE places ahead of
+ * the current one, and the next leaf's array of children, so that scans
+ * over large lists do not stall on each item.  Build with
+ * -DBLIST_PREFETCH_DISTANCE=0 to turn prefetching off. */
+#ifndef BLIST_PREFETCH_DISTANCE
+#define BLIST_PREFETCH_DISTANCE (8)
+#endif
+#if defined(__GNUC__) && BLIST_PREFETCH_DISTANCE > 0
+#define BLIST_PREFETCH(addr) __builtin_prefetch((addr), 0, 1)
+#else
+#define BLIST_PREFETCH(addr) ((void) 0)
+#endif
+
+/* Prefetch the item in leaf p that is DISTANCE places after index i */
+#define PREFETCH_AHEAD(p, i) do { \
+        if ((i) + BLIST_PREFETCH_DISTANCE < (p)->num_children) \
+                BLIST_PREFETCH((p)->children[(i) + BLIST_PREFETCH_DISTANCE]); \
+        } while (0)
+
+/* Likewise, for iteration in reverse */
+#define PREFETCH_BEHIND(p, i) do { \
+        if ((i) - BLIST_PREFETCH_DISTANCE >= 0) \
+                BLIST_PREFETCH((p)->children[(i) - BLIST_PREFETCH_DISTANCE]); \
+        } while (0)
+
 #ifndef BLIST_IN_PYTHON
 #include "blist.h"
 #endif
@@ -147,10 +184,14 @@ typedef struct {
         iter_t iter;
 } blistiterobject;
 
-/* Empty BList reuse scheme to save calls to malloc and free */
+/* Empty BList reuse scheme to save calls to malloc and free.  The
+ * number of cached internal nodes can be changed with
+ * set_cache_limits(), so free_lists grows on demand. */
 #define MAXFREELISTS 80
-static PyBList *free_lists[MAXFREELISTS];
+static PyBList **free_lists = NULL;
 static int num_free_lists = 0;
+static int max_free_lists = MAXFREELISTS;
+static int allocated_free_lists = 0;
 
 static PyBList *free_ulists[MAXFREELISTS];
 static int num_free_ulists = 0;
@@ -162,7 +203,7 @@ typedef struct sortwrapperobject
 {
         union {
                 unsigned long k_ulong;
-#ifdef BLIST_FLOAT_RADIX_SORT
+#if defined(BLIST_FLOAT_RADIX_SORT) || defined(BLIST_WIDE_RADIX_SORT)
                 PY_UINT64_T k_uint64;
 #endif
         } fkey;
@@ -174,7 +215,7 @@ typedef struct sortwrapperobject
 #define PyRootBList_Check(op) (PyObject_TypeCheck((op), &PyRootBList_Type))
 #define PyRootBList_CheckExact(op) (Py_TYPE((op)) == &PyRootBList_Type)
 #define PyBList_CheckExact(op) ((op)->ob_type == &PyBList_Type || (op)->ob_type == &PyRootBList_Type)
-#define PyBListIter_Check(op) (PyObject_TypeCheck((op), &PyBListIter_Type) || (PyObject_TypeCheck((op), &PyBListReverseIter_Type)))
+#define PyBListIter_Check(op) (PyObject_TypeCheck((op), &PyBListIter_Type) || (PyObject_TypeCheck((op), &PyBListReverseIter_Type)) || (PyObject_TypeCheck((op), &PyBListChunkIter_Type)))
 
 #define INDEX_LENGTH(self) (((self)->n-1) / INDEX_FACTOR + 1)
 
@@ -191,6 +232,7 @@ copy(PyBList *self, int k, PyBList *other, int k2, int n)
         PyObject **stop = &other->children[k2+n];
 
         assert(self != other);
+        self->sizes_valid = 0;
 
         while (src < stop)
                 *dst++ = *src++;
@@ -203,6 +245,7 @@ copyref(PyBList *self, int k, PyBList *other, int k2,int n) {
         PyObject **restrict dst = &self->children[k];
         PyObject **stop = &src[n];
 
+        self->sizes_valid = 0;
         while (src < stop) {
                 Py_INCREF(*src);
                 *dst++ = *src++;
@@ -216,6 +259,7 @@ xcopyref(PyBList *self, int k, PyBList *other,int k2,int n) {
         PyObject **restrict dst = &self->children[k];
         PyObject **stop = &src[n];
 
+        self->sizes_valid = 0;
         while (src < stop) {
                 Py_XINCREF(*src);
                 *dst++ = *src++;
@@ -230,6 +274,7 @@ shift_right(PyBList *self, int k, int n)
         PyObject **dst = &self->children[self->num_children-1 + n];
         PyObject **stop = &self->children[k];
 
+        self->sizes_valid = 0;
         if (self->num_children == 0)
                 return;
 
@@ -249,6 +294,7 @@ shift_left(PyBList *self, int k, int n)
         PyObject **dst = &self->children[k - n];
         PyObject **stop = &self->children[self->num_children];
 
+        self->sizes_valid = 0;
         assert(k - n >= 0);
         assert(k >= 0);
         assert(k <= LIMIT);
@@ -307,6 +353,7 @@ balance_leafs(PyBList *restrict leaf1, PyBList *restrict leaf2)
         if (lst->leaf) { \
                 Py_ssize_t _i; _use_iter = 0; \
                 for (_i = (start); _i < lst->num_children && _i < (stop); _i++) { \
+                        PREFETCH_AHEAD(lst, _i); \
                         item = lst->children[_i]; \
                         block; \
                 } \
@@ -317,6 +364,7 @@ balance_leafs(PyBList *restrict leaf1, PyBList *restrict leaf2)
                 _p = _it.leaf; \
                 while (_p != NULL && _remaining--) { \
                         if (_it.i < _p->num_children) { \
+                                PREFETCH_AHEAD(_p, _it.i); \
                                 item = _p->children[_it.i++]; \
                         } else { \
                                 item = iter_next(&_it); \
@@ -335,6 +383,7 @@ balance_leafs(PyBList *restrict leaf1, PyBList *restrict leaf2)
                 iter_t _it; \
                 Py_ssize_t _i; const int _use_iter = 0;\
                 for (_i = 0; _i < (lst)->num_children; _i++) { \
+                        PREFETCH_AHEAD((lst), _i); \
                         item = (lst)->children[_i]; \
                         block; \
                 } ITER_CLEANUP(); \
@@ -346,6 +395,7 @@ balance_leafs(PyBList *restrict leaf1, PyBList *restrict leaf2)
                 _p = _it.leaf; \
                 while (_p) { \
                         if (_it.i < _p->num_children) { \
+                                PREFETCH_AHEAD(_p, _it.i); \
                                 item = _p->children[_it.i++]; \
                         } else { \
                                 item = iter_next(&_it); \
@@ -366,7 +416,10 @@ PyTypeObject PyBList_Type;
 PyTypeObject PyRootBList_Type;
 PyTypeObject PyBListIter_Type;
 PyTypeObject PyBListReverseIter_Type;
+PyTypeObject PyBListChunkIter_Type;
+PyTypeObject PyBListCursor_Type;
 static void ext_init(PyBListRoot *root);
+static void ext_policy_init(PyBListRoot *root);
 static void ext_mark(PyBList *broot, Py_ssize_t offset, int value);
 static void ext_mark_set_dirty(PyBList *broot, Py_ssize_t i, Py_ssize_t j);
 static void ext_mark_set_dirty_all(PyBList *broot);
@@ -1105,6 +1158,227 @@ balance_last_2(PyBList **out, int n)
         return n;
 }
 
+/************************************************************************
+ * Children arrays
+ *
+ * Every root has a separate array of LIMIT children (internal nodes
+ * keep theirs inline; see INLINE_CHILDREN below).  These are too big for
+ * Python's small object allocator, so allocating each with PyMem_New
+ * would mean a malloc() and free() per root.  Instead, we carve them
+ * out of slabs of SLAB_ARRAYS arrays.  Each array is preceded by a
+ * pointer to its slab, and each slab keeps a free list threaded through
+ * its unused arrays.  Slabs with free arrays are on a doubly-linked
+ * list.  We keep up to max_free_slabs completely unused slabs around;
+ * beyond that, they go back to the system.
+ */
+
+#define SLAB_ARRAYS 64
+#define MAXFREESLABS 16
+
+typedef struct slab {
+        struct slab *prev, *next;  /* Slabs with free arrays */
+        PyObject **free;           /* Free arrays, linked through [0] */
+        int num_free;
+} slab_t;
+
+static slab_t *partial_slabs = NULL;
+static int num_free_slabs = 0;
+static int max_free_slabs = MAXFREESLABS;
+
+BLIST_LOCAL_INLINE(void)
+slab_link(slab_t *slab)
+{
+        slab->prev = NULL;
+        slab->next = partial_slabs;
+        if (partial_slabs)
+                partial_slabs->prev = slab;
+        partial_slabs = slab;
+}
+
+BLIST_LOCAL_INLINE(void)
+slab_unlink(slab_t *slab)
+{
+        if (slab->prev)
+                slab->prev->next = slab->next;
+        else
+                partial_slabs = slab->next;
+        if (slab->next)
+                slab->next->prev = slab->prev;
+}
+
+static slab_t *slab_new(void)
+{
+        slab_t *slab;
+        PyObject **block;
+        int i;
+
+        slab = PyMem_Malloc(sizeof(slab_t)
+                            + SLAB_ARRAYS * (LIMIT+1) * sizeof(PyObject *));
+        if (slab == NULL)
+                return NULL;
+
+        block = (PyObject **) (slab + 1);
+        slab->free = NULL;
+        for (i = 0; i < SLAB_ARRAYS; i++, block += LIMIT+1) {
+                block[0] = (PyObject *) slab;
+                block[1] = (PyObject *) slab->free;
+                slab->free = &block[1];
+        }
+        slab->num_free = SLAB_ARRAYS;
+        slab_link(slab);
+        num_free_slabs++;
+
+        return slab;
+}
+
+/* Returns a new array of LIMIT children, or NULL on error */
+static PyObject **children_new(void)
+{
+        slab_t *slab = partial_slabs;
+        PyObject **children;
+
+        if (slab == NULL) {
+                slab = slab_new();
+                if (slab == NULL) {
+                        PyErr_NoMemory();
+                        return NULL;
+                }
+        }
+
+        if (slab->num_free == SLAB_ARRAYS)
+                num_free_slabs--;
+        children = slab->free;
+        slab->free = (PyObject **) children[0];
+        if (--slab->num_free == 0)
+                slab_unlink(slab);
+
+        return children;
+}
+
+static void children_free(PyObject **children)
+{
+        slab_t *slab = (slab_t *) children[-1];
+
+        children[0] = (PyObject *) slab->free;
+        slab->free = children;
+        if (slab->num_free++ == 0)
+                slab_link(slab);
+        if (slab->num_free < SLAB_ARRAYS)
+                return;
+
+        if (num_free_slabs < max_free_slabs)
+                num_free_slabs++;
+        else {
+                slab_unlink(slab);
+                PyMem_Free(slab);
+        }
+}
+
+/* Return unused slabs to the system, keeping at most max of them */
+static void slabs_trim(int max)
+{
+        slab_t *slab, *next;
+
+        for (slab = partial_slabs; slab && num_free_slabs > max; slab = next) {
+                next = slab->next;
+                if (slab->num_free < SLAB_ARRAYS)
+                        continue;
+                slab_unlink(slab);
+                PyMem_Free(slab);
+                num_free_slabs--;
+        }
+}
+
+/* Internal nodes carry their children inline, directly after the
+ * PyBList header, so that following a child pointer touches the same
+ * allocation (and usually the same cache line) as the node's counts.
+ * Roots keep a separately allocated array, which py_blist_sort swaps out
+ * while sorting. */
+#define INLINE_CHILDREN(self) ((PyObject **) (((PyBList *) (self)) + 1))
+#define HAS_INLINE_CHILDREN(self) \
+        (((PyBList *) (self))->children == INLINE_CHILDREN(self))
+
+/* A root's array starts out empty and grows geometrically, as CPython's
+ * lists do, so that small lists stay small.  Only a leaf root may have
+ * fewer than LIMIT slots: anything that may add more than one child to a
+ * root, or turn it into an internal node, calls blist_root_reserve()
+ * first.  Full-sized arrays come from the slabs; smaller ones from
+ * PyMem_New. */
+static void root_children_free(PyBListRoot *root)
+{
+        if (root->allocated == LIMIT)
+                children_free(root->children);
+        else
+                PyMem_Free(root->children);
+}
+
+/* Make room for at least n children (n is capped at LIMIT) in a root.
+ * Does nothing for internal nodes, which always have LIMIT.  Returns -1
+ * and sets MemoryError on failure.
+ */
+BLIST_LOCAL(int)
+blist_root_reserve(PyBList *self, Py_ssize_t n)
+{
+        PyBListRoot *root = (PyBListRoot *) self;
+        PyObject **children;
+        Py_ssize_t allocated;
+
+        if (n > LIMIT)
+                n = LIMIT;
+        if (HAS_INLINE_CHILDREN(self) || n <= root->allocated)
+                return 0;
+
+        allocated = n + (n >> 3) + (n < 9 ? 3 : 6);
+        if (allocated >= LIMIT) {
+                children = children_new();
+                if (children == NULL)
+                        return -1;
+                if (self->num_children)
+                        memcpy(children, self->children,
+                               self->num_children * sizeof(PyObject *));
+                PyMem_Free(self->children);
+                allocated = LIMIT;
+        } else {
+                children = self->children;
+                PyMem_Resize(children, PyObject *, allocated);
+                if (children == NULL) {
+                        PyErr_NoMemory();
+                        return -1;
+                }
+        }
+
+        self->children = children;
+        root->allocated = (int) allocated;
+        return 0;
+}
+
+/* Make room in self->sizes for a count per child.  The array grows as
+ * a root's children do, so that it stays close to num_children rather
+ * than always taking LIMIT counts.  Returns 0 if it could not be
+ * allocated (without setting an exception).
+ */
+BLIST_LOCAL(int)
+blist_sizes_reserve(PyBList *self)
+{
+        Py_ssize_t *sizes;
+        int n = self->num_children;
+        int allocated;
+
+        if (n <= self->sizes_allocated)
+                return 1;
+
+        allocated = n + (n >> 3) + (n < 9 ? 3 : 6);
+        if (allocated > LIMIT)
+                allocated = LIMIT;
+        sizes = (Py_ssize_t *) PyMem_Realloc(self->sizes,
+                                             allocated * sizeof(Py_ssize_t));
+        if (sizes == NULL)
+                return 0;
+        self->sizes = sizes;
+        self->sizes_allocated = allocated;
+        return 1;
+}
+
 /************************************************************************
  * Back to BLists proper.
  */
@@ -1123,15 +1397,13 @@ static PyBList *blist_new(void)
                 DANGER_GC_END;
                 if (self == NULL)
                         return NULL;
-                self->children = PyMem_New(PyObject *, LIMIT);
-                if (self->children == NULL) {
-                        PyObject_GC_Del(self);
-                        PyErr_NoMemory();
-                        return NULL;
-                }
+                self->children = INLINE_CHILDREN(self);
+                self->sizes = NULL;
+                self->sizes_allocated = 0;
         }
 
         self->leaf = 1; /* True */
+        self->sizes_valid = 0;
         self->num_children = 0;
         self->n = 0;
 
@@ -1161,25 +1433,39 @@ static PyBList *blist_root_new(void)
                 DANGER_GC_END;
                 if (self == NULL)
                         return NULL;
-                self->children = PyMem_New(PyObject *, LIMIT);
-                if (self->children == NULL) {
-                        PyObject_GC_Del(self);
-                        PyErr_NoMemory();
-                        return NULL;
-                }
+                self->children = NULL;
+                ((PyBListRoot *) self)->allocated = 0;
+                self->sizes = NULL;
+                self->sizes_allocated = 0;
         }
 
         self->leaf = 1; /* True */
+        self->sizes_valid = 0;
         self->n = 0;
         self->num_children = 0;
+        ((PyBListRoot *) self)->sorted_n = 0;
+        ((PyBListRoot *) self)->generation = 0;
 
         ext_init((PyBListRoot *) self);
+        ext_policy_init((PyBListRoot *) self);
 
         PyObject_GC_Track(self);
 
         return self;
 }
 
+/* Called when the items of a root from position i onwards may have
+ * changed, other than by appending.  Only the items before i are still
+ * known to be sorted. */
+BLIST_LOCAL_INLINE(void)
+sorted_prefix_cut(PyBList *self, Py_ssize_t i)
+{
+        PyBListRoot *root = (PyBListRoot *) self;
+
+        if (root->sorted_n > i)
+                root->sorted_n = i;
+}
+
 /* Remove links to some of our children, decrementing their refcounts */
 static void blist_forget_children2(PyBList *self, int i, int j)
 {
@@ -1189,6 +1475,7 @@ static void blist_forget_children2(PyBList *self, int i, int j)
 
         shift_left_decref(self, j, delta);
         self->num_children -= delta;
+        self->sizes_valid = 0;
 
         _void();
 }
@@ -1220,12 +1507,22 @@ blist_become(PyBList *restrict self, PyBList *restrict other)
         invariants(self, VALID_RW);
         assert(self != other);
 
+        assert(HAS_INLINE_CHILDREN(self)
+               || ((PyBListRoot *) self)->allocated
+               >= (other->leaf ? other->num_children : LIMIT));
+
         Py_INCREF(other); /* "other" may be one of self's children */
         blist_forget_children(self);
         self->n = other->n;
         xcopyref(self, 0, other, 0, other->num_children);
         self->num_children = other->num_children;
         self->leaf = other->leaf;
+        if (other->sizes_valid && self->sizes != NULL
+            && blist_sizes_reserve(self)) {
+                memcpy(self->sizes, other->sizes,
+                       other->num_children * sizeof(Py_ssize_t));
+                self->sizes_valid = 1;
+        }
 
         SAFE_DECREF(other);
         _void();
@@ -1243,13 +1540,27 @@ blist_become_and_consume(PyBList *restrict self, PyBList *restrict other)
 
         Py_INCREF(other);
         blist_forget_children(self);
-        tmp = self->children;
-        self->children = other->children;
+        if (HAS_INLINE_CHILDREN(self) || HAS_INLINE_CHILDREN(other)) {
+                assert(HAS_INLINE_CHILDREN(self)
+                       || ((PyBListRoot *) self)->allocated
+                       >= (other->leaf ? other->num_children : LIMIT));
+                memcpy(self->children, other->children,
+                       other->num_children * sizeof(PyObject *));
+        } else {
+                int allocated = ((PyBListRoot *) self)->allocated;
+                tmp = self->children;
+                self->children = other->children;
+                other->children = tmp;
+                ((PyBListRoot *) self)->allocated
+                        = ((PyBListRoot *) other)->allocated;
+                ((PyBListRoot *) other)->allocated = allocated;
+        }
         self->n = other->n;
         self->num_children = other->num_children;
         self->leaf = other->leaf;
+        self->sizes_valid = 0;
 
-        other->children = tmp;
+        other->sizes_valid = 0;
         other->n = 0;
         other->num_children = 0;
         other->leaf = 1;
@@ -1276,7 +1587,12 @@ static PyBList *blist_root_copy(PyBList *restrict self)
 
         copy = blist_root_new();
         if (!copy) return NULL;
+        if (blist_root_reserve(copy, self->leaf ? self->n : LIMIT) < 0) {
+                SAFE_DECREF(copy);
+                return NULL;
+        }
         blist_become(copy, self);
+        ((PyBListRoot *) copy)->sorted_n = ((PyBListRoot *) self)->sorted_n;
         ext_mark(copy, 0, DIRTY);
         ext_mark_set_dirty_all(self);
         return copy;
@@ -1286,6 +1602,37 @@ static PyBList *blist_root_copy(PyBList *restrict self)
  * Useful internal utility functions
  */
 
+/* Make self->sizes hold the ->n of each of self's children, so that
+ * searches can scan one contiguous array instead of visiting every
+ * child.  The array is allocated on first use.  Returns 0 if it could
+ * not be allocated (without setting an exception); the caller should
+ * then fall back on reading the children directly.
+ */
+BLIST_LOCAL(int)
+blist_sizes_ready(PyBList *self)
+{
+        int k;
+
+        assert(!self->leaf);
+
+        if (self->sizes_valid) {
+#ifdef Py_DEBUG
+                for (k = 0; k < self->num_children; k++)
+                        assert(self->sizes[k]
+                               == ((PyBList *) self->children[k])->n);
+#endif
+                return 1;
+        }
+
+        if (!blist_sizes_reserve(self))
+                return 0;
+        for (k = 0; k < self->num_children; k++)
+                self->sizes[k] = ((PyBList *) self->children[k])->n;
+        self->sizes_valid = 1;
+
+        return 1;
+}
+
 /* We are searching for the child that contains leaf element i.
  *
  * Returns a 3-tuple: (the child object, our index of the child,
@@ -1297,6 +1644,28 @@ static void blist_locate(PyBList *self, Py_ssize_t i,
         invariants(self, VALID_PARENT);
         assert (!self->leaf);
 
+        if (blist_sizes_ready(self)) {
+                Py_ssize_t *sizes = self->sizes;
+                Py_ssize_t so_far;
+                int k;
+
+                if (i <= self->n/2) {
+                        for (so_far = 0, k = 0; k < self->num_children-1
+                                     && i >= so_far + sizes[k]; k++)
+                                so_far += sizes[k];
+                } else {
+                        so_far = self->n - sizes[self->num_children-1];
+                        for (k = self->num_children-1; k > 0 && i < so_far;)
+                                so_far -= sizes[--k];
+                }
+
+                *child = self->children[k];
+                *idx = k;
+                *before = so_far;
+                _void();
+                return;
+        }
+
         if (i <= self->n/2) {
                 /* Search from the left */
                 Py_ssize_t so_far = 0;
@@ -1379,6 +1748,7 @@ blist_prepare_write(PyBList *self, int pt)
         invariants(self, VALID_RW);
         assert(!self->leaf);
 
+        self->sizes_valid = 0;
         if (pt < 0)
                 pt += self->num_children;
         if (Py_REFCNT(self->children[pt]) > 1) {
@@ -1393,7 +1763,7 @@ blist_prepare_write(PyBList *self, int pt)
 }
 
 /* Macro version assumes that pt is non-negative */
-#define blist_PREPARE_WRITE(self, pt) (Py_REFCNT((self)->children[(pt)]) > 1 ? blist_prepare_write((self), (pt)) : (PyBList *) (self)->children[(pt)])
+#define blist_PREPARE_WRITE(self, pt) (Py_REFCNT((self)->children[(pt)]) > 1 ? blist_prepare_write((self), (pt)) : ((self)->sizes_valid = 0, (PyBList *) (self)->children[(pt)]))
 
 /* Recompute self->n */
 BLIST_LOCAL(void)
@@ -1409,8 +1779,16 @@ blist_adjust_n(PyBList *restrict self)
                 return;
         }
         self->n = 0;
-        for (i = 0; i < self->num_children; i++)
-                self->n += ((PyBList *)self->children[i])->n;
+        if (self->sizes != NULL && blist_sizes_reserve(self)) {
+                for (i = 0; i < self->num_children; i++) {
+                        self->sizes[i] = ((PyBList *)self->children[i])->n;
+                        self->n += self->sizes[i];
+                }
+                self->sizes_valid = 1;
+        } else {
+                for (i = 0; i < self->num_children; i++)
+                        self->n += ((PyBList *)self->children[i])->n;
+        }
 
         _void();
 }
@@ -1487,6 +1865,9 @@ static void ext_init(PyBListRoot *root)
         root->dirty_length = 0;
         root->dirty_root = DIRTY;
         root->free_root = -1;
+        root->finger = NULL;
+        root->finger_offset = 0;
+        root->finger_rw = 0;
 
 #ifdef Py_DEBUG
         root->last_n = root->n;
@@ -1501,13 +1882,70 @@ static void ext_dealloc(PyBListRoot *root)
         if (root->setclean_list) PyMem_Free(root->setclean_list);
         if (root->dirty) PyMem_Free(root->dirty);
         ext_init(root);
+        root->generation++;
+}
+
+/* The index costs O(n/INDEX_FACTOR) memory and must be repaired after
+ * most modifications, which only pays off for lists that are read by
+ * position.  A root therefore serves reads by walking the tree until
+ * index_build reads have missed the index, and only then starts
+ * building it.  Modifications that dirty the index and new iterators
+ * are "idle" events; after index_drop of them with no read in between,
+ * the index is freed and must be earned again.
+ */
+#define INDEX_BUILD_DEFAULT (16)
+#define INDEX_DROP_DEFAULT (1024)
+#define EXT_INDEXED(root) ((root)->index_build >= 0 \
+                           && (root)->index_reads >= (root)->index_build)
+
+static void ext_policy_init(PyBListRoot *root)
+{
+        root->index_build = INDEX_BUILD_DEFAULT;
+        root->index_drop = INDEX_DROP_DEFAULT;
+        root->index_reads = 0;
+        root->index_idle = 0;
+}
+
+/* Free the index and start counting reads toward rebuilding it */
+static void ext_drop_index(PyBListRoot *root)
+{
+        ext_dealloc(root);
+        root->index_reads = 0;
+        root->index_idle = 0;
+}
+
+/* A read or write by position missed the index.  Returns true if the
+ * index should be used (and repaired) to serve it. */
+BLIST_LOCAL_INLINE(int)
+ext_want_index(PyBListRoot *root)
+{
+        root->index_idle = 0;
+        if (root->index_reads < root->index_build) {
+                root->index_reads++;
+                return 0;
+        }
+        return root->index_build >= 0;
+}
+
+/* Count an idle event, dropping the index after too many.  Returns true
+ * if the index was dropped. */
+BLIST_LOCAL_INLINE(int)
+ext_note_idle(PyBListRoot *root)
+{
+        if (!EXT_INDEXED(root) || root->index_drop <= 0
+            || ++root->index_idle < root->index_drop)
+                return 0;
+        ext_drop_index(root);
+        return 1;
 }
 
 /* Find or create a new free node in "dirty" and return an index to it.
- * amortized O(1) */
+ * amortized O(1), worst-case O(log n) apart from growing "dirty" */
+static void ext_free(PyBListRoot *root, Py_ssize_t loc);
+
 static Py_ssize_t ext_alloc(PyBListRoot *root)
 {
-        Py_ssize_t i, parent;
+        Py_ssize_t i;
 
         if (root->free_root < 0) {
                 int newl;
@@ -1545,66 +1983,41 @@ static Py_ssize_t ext_alloc(PyBListRoot *root)
                 assert(root->free_root+1 < root->dirty_length);
         }
 
-        /* Depth-first search for a node with fewer than 2 children.
-         * Guaranteed to terminate in O(log n) since any leaf node
-         * will suffice.
-         */
-
+        /* Pop the top of the free stack.  Any subtree still hanging
+         * off its right-hand pointer is pushed in its place. */
         i = root->free_root;
-        parent = -1;
         assert(i >= 0);
         assert(i+1 < root->dirty_length);
-        while (root->dirty[i] >= 0 && root->dirty[i+1] >= 0) {
-                assert(0);
-                assert(i >= 0);
-                assert(i+1 < root->dirty_length);
-                parent = i;
-                i = root->dirty[i];
-        }
-
-        /* At this point, "i" is the node to be alloced.  "parent" is
-         * the node containing a pointer to "i" or -1 if free_root
-         * points to "i"
-         *
-         * parent's pointer to i is always the left-hand pointer
-         *
-         * i has at most one child
-         */
-
-        if (parent < 0) {
-                if (root->dirty[i] >= 0)
-                        root->free_root = root->dirty[i];
-                else
-                        root->free_root = root->dirty[i+1];
-        } else {
-                if (root->dirty[i] >= 0)
-                        root->dirty[parent] = root->dirty[i];
-                else
-                        root->dirty[parent] = root->dirty[i+1];
-        }
+        root->free_root = root->dirty[i];
+        if (root->dirty[i+1] >= 0)
+                ext_free(root, root->dirty[i+1]);
 
         assert(i >= 0);
         assert(i+1 < root->dirty_length);
         return i;
 }
 
-/* Add each node in the tree rooted at loc to the free tree */
-/* Amortized O(1), since each node to be freed corresponds with
- * an earlier lookup.  Unamortized worst-case O(n)*/
+/* Add each node in the tree rooted at loc to the free tree.
+ *
+ * The free tree is a stack linked through the left-hand pointers.  A
+ * freed node keeps its right-hand subtree, which ext_alloc() pushes
+ * when the node is reused, so only the left spine of loc is walked
+ * here.  Both functions are O(log n) in the worst case, no matter how
+ * large the freed tree is.
+ */
 static void ext_free(PyBListRoot *root, Py_ssize_t loc)
 {
+        Py_ssize_t i = loc;
+
         assert(loc >= 0);
         assert(loc+1 < root->dirty_length);
-        if (root->dirty[loc] >= 0)
-                ext_free(root, root->dirty[loc]);
-        if (root->dirty[loc+1] >= 0)
-                ext_free(root, root->dirty[loc+1]);
+        while (root->dirty[i] >= 0) {
+                i = root->dirty[i];
+                assert(i+1 < root->dirty_length);
+        }
 
-        root->dirty[loc] = root->free_root;
-        root->dirty[loc+1] = -1;
+        root->dirty[i] = root->free_root;
         root->free_root = loc;
-        assert(root->free_root >= 0);
-        assert(root->free_root+1 < root->dirty_length);
 }
 
 BLIST_LOCAL(void)
@@ -1678,12 +2091,20 @@ static void ext_mark(PyBList *broot, Py_ssize_t offset, int value)
         int bit;
 
         PyBListRoot *root = (PyBListRoot*) broot;
+        if (value == DIRTY) {
+                root->generation++;
+                if (root->finger != NULL
+                    && offset < root->finger_offset + LIMIT)
+                        root->finger = NULL;
+        }
         if (!root->n) {
 #ifdef Py_DEBUG
                 root->last_n = root->n;
 #endif
                 return;
         }
+        if (value == DIRTY && ext_note_idle(root))
+                return;
         if ((!offset && value == DIRTY) || root->n <= INDEX_FACTOR) {
                 if (root->dirty_root >= 0)
                         ext_free(root, root->dirty_root);
@@ -1701,7 +2122,9 @@ static void ext_mark(PyBList *broot, Py_ssize_t offset, int value)
         if (root->dirty_root == value) return;
 
         if (root->dirty_root < 0) {
-                Py_ssize_t nvalue = root->dirty_root;
+                /* CLEAN_RW is only valid for dirty_root itself */
+                Py_ssize_t nvalue = root->dirty_root == CLEAN_RW
+                        ? CLEAN : root->dirty_root;
                 root->dirty_root = ext_alloc(root);
                 if (root->dirty_root < 0) {
                         ext_dealloc(root);
@@ -1740,6 +2163,33 @@ static void ext_mark_set_dirty_all(PyBList *broot)
         ext_mark_set_dirty(broot, 0, broot->n);
 }
 
+/* One item was just inserted or deleted at position i of a root that
+ * held old_n items.  Only the leaf holding position i and its left
+ * neighbour can have been split, merged, borrowed from or copied, and
+ * neither starts before i - 2*LIMIT, so index entries to the left of
+ * that remain valid.  The whole index is dirtied if the root is a
+ * leaf, if the dirty tree changed depth, or if the index lost its last
+ * entry.  O(log n), regardless of where i is.
+ */
+static void ext_mark_moved(PyBList *broot, Py_ssize_t i, Py_ssize_t old_n)
+{
+        PyBListRoot *root = (PyBListRoot *) broot;
+        Py_ssize_t old_last = (old_n - 1) / INDEX_FACTOR;
+        Py_ssize_t last = (root->n - 1) / INDEX_FACTOR;
+
+        if (root->leaf || old_n <= INDEX_FACTOR || root->n <= INDEX_FACTOR
+            || last < old_last
+            || highest_set_bit(last) != highest_set_bit(old_last)) {
+                ext_mark(broot, 0, DIRTY);
+                return;
+        }
+
+#ifdef Py_DEBUG
+        root->last_n = root->n;
+#endif
+        ext_mark(broot, i > 2*LIMIT ? i - 2*LIMIT : 0, DIRTY);
+}
+
 #if 0
 /* These functions are unused, but useful for debugging.  Do not remove. */
 
@@ -2019,12 +2469,16 @@ _ext_reindex_all(PyBListRoot *root, int set_ok_all)
         if (root->dirty_root >= 0)
                 ext_free(root, root->dirty_root);
         root->dirty_root = DIRTY;
+        root->finger = NULL;
+        root->generation++;
 
         _ext_index_all(root, set_ok_all);
 }
 
-#define ext_reindex_all(root) do { if (!(root)->leaf) _ext_reindex_all((root), 0); } while (0)
-#define ext_reindex_set_all(root) do { if (!(root)->leaf) _ext_reindex_all((root), 1); } while (0)
+/* Rebuild the index from scratch, or just discard the old one if the
+ * root has not earned an index. */
+#define ext_reindex_all(root) do { if ((root)->leaf) ; else if (EXT_INDEXED(root)) _ext_reindex_all((root), 0); else ext_dealloc(root); } while (0)
+#define ext_reindex_set_all(root) do { if ((root)->leaf) ; else if (EXT_INDEXED(root)) _ext_reindex_all((root), 1); else ext_dealloc(root); } while (0)
 
 /* We found a particular node at a certain offset.  Add it to the
  * index and mark it clean. */
@@ -2060,27 +2514,63 @@ ext_mark_clean(PyBListRoot *root, Py_ssize_t offset, PyBList *p, int setclean)
         }
 }
 
-/* Lookup the node at offset i and mark it clean */
-static PyObject *ext_make_clean(PyBListRoot *root, Py_ssize_t i)
+/* The finger caches the leaf found by the last slow read or write, so
+ * that nearby accesses skip both the tree walk and the index.  Like an
+ * index entry, it stays valid until the index is marked dirty at or
+ * before its leaf; finger_rw additionally means every node on the way
+ * to it is referenced only once, like a set bit in setclean_list.
+ */
+#define EXT_FINGER_HAS(root, i) ((root)->finger != NULL \
+                && (i) >= (root)->finger_offset \
+                && (i) - (root)->finger_offset < (root)->finger->n)
+
+BLIST_LOCAL_INLINE(void)
+ext_set_finger(PyBListRoot *root, PyBList *p, Py_ssize_t offset, int rw)
+{
+        root->finger = p;
+        root->finger_offset = offset;
+        root->finger_rw = rw;
+}
+
+/* Find the leaf holding position i.  Sets *poffset to the position of
+ * its first item, and *psetclean to whether every node on the way is
+ * referenced only once. */
+BLIST_LOCAL(PyBList *)
+ext_find_leaf(PyBListRoot *root, Py_ssize_t i, Py_ssize_t *poffset,
+              int *psetclean)
 {
-        PyObject *rv;
         Py_ssize_t so_far;
         Py_ssize_t offset = 0;
         PyBList *p = (PyBList *)root;
-        Py_ssize_t j = i;
+        PyObject *child;
         int k;
         int setclean = 1;
         do {
-                blist_locate(p, j, (PyObject **) &p, &k, &so_far);
+                blist_locate(p, i, &child, &k, &so_far);
+                p = (PyBList *) child;
                 if (Py_REFCNT(p) > 1)
                         setclean = 0;
                 offset += so_far;
-                j -= so_far;
+                i -= so_far;
         } while (!p->leaf);
 
-        rv = p->children[j];
+        *poffset = offset;
+        *psetclean = setclean;
+        return p;
+}
+
+/* Lookup the node at offset i and mark it clean.  If finger is true,
+ * also remember the node as the finger. */
+static PyObject *ext_make_clean(PyBListRoot *root, Py_ssize_t i, int finger)
+{
+        Py_ssize_t offset;
+        int setclean;
+        PyBList *p = ext_find_leaf(root, i, &offset, &setclean);
+
         ext_mark_clean(root, offset, p, setclean);
-        return rv;
+        if (finger)
+                ext_set_finger(root, p, offset, setclean);
+        return p->children[i - offset];
 }
 
 /************************************************************************
@@ -2357,6 +2847,8 @@ blist_overflow_root(PyBList *self, PyBList *overflow)
         invariants(self, VALID_RW);
 
         if (!overflow) return _int(0);
+        assert(HAS_INLINE_CHILDREN(self)
+               || ((PyBListRoot *) self)->allocated == LIMIT);
         child = blist_new();
         if (!child) {
                 decref_later((PyObject*)overflow);
@@ -2522,7 +3014,8 @@ ins1(PyBList *self, Py_ssize_t i, PyObject *item)
 {
         PyBList *ret;
         PyBList *restrict p;
-        int k;
+        PyObject *child;
+        int k, sizes_valid;
         Py_ssize_t so_far;
         PyBList *overflow;
 
@@ -2543,14 +3036,23 @@ ins1(PyBList *self, Py_ssize_t i, PyObject *item)
                 return _blist(blist_insert_here(self, i, item));
         }
 
-        blist_locate(self, i, (PyObject **) &p, &k, &so_far);
+        blist_locate(self, i, &child, &k, &so_far);
+        p = (PyBList *) child;
 
         self->n += 1;
+        sizes_valid = self->sizes_valid;
         p = blist_prepare_write(self, k);
         overflow = ins1(p, i - so_far, item);
 
-        if (!overflow) ret = NULL;
-        else ret = blist_insert_here(self, k+1, (PyObject *) overflow);
+        if (!overflow) {
+                ret = NULL;
+                if (sizes_valid) {
+                        /* Only child k changed, and only by one */
+                        self->sizes[k]++;
+                        self->sizes_valid = 1;
+                }
+        } else
+                ret = blist_insert_here(self, k+1, (PyObject *) overflow);
 
         return _blist(ret);
 }
@@ -2562,6 +3064,10 @@ blist_extend_blist(PyBList *self, PyBList *other)
 
         invariants(self, VALID_RW);
 
+        if (blist_root_reserve(self, self->leaf && other->leaf
+                               ? self->n + other->n : LIMIT) < 0)
+                return _int(-1);
+
         /* Special case for speed */
         if (self->leaf && other->leaf && self->n + other->n <= LIMIT) {
                 copyref(self, self->n, other, 0, other->n);
@@ -2608,7 +3114,8 @@ static int blist_delslice(PyBList *self, Py_ssize_t i, Py_ssize_t j)
          */
 
         PyBList *restrict p, *restrict p2;
-        int k, k2, depth;
+        PyObject *child, *child2;
+        int k, k2, depth, sizes_valid;
         Py_ssize_t so_far, so_far2, low;
         int collapse_left, collapse_right, deleted_k, deleted_k2;
 
@@ -2633,8 +3140,10 @@ static int blist_delslice(PyBList *self, Py_ssize_t i, Py_ssize_t j)
                 return _int(0);
         }
 
-        blist_locate(self, i, (PyObject **) &p, &k, &so_far);
-        blist_locate(self, j-1, (PyObject **) &p2, &k2, &so_far2);
+        blist_locate(self, i, &child, &k, &so_far);
+        blist_locate(self, j-1, &child2, &k2, &so_far2);
+        p = (PyBList *) child;
+        p2 = (PyBList *) child2;
 
         if (k == k2) {
                 /* All of the deleted elements are contained under a single
@@ -2643,8 +3152,24 @@ static int blist_delslice(PyBList *self, Py_ssize_t i, Py_ssize_t j)
                  */
 
                 assert(so_far == so_far2);
+                sizes_valid = self->sizes_valid;
                 p = blist_prepare_write(self, k);
                 depth = blist_delslice(p, i - so_far, j - so_far);
+                if (sizes_valid && !depth && self->num_children > 1
+                    && p->num_children >= HALF
+                    && (k == 0 || ((PyBList *) self->children[k-1])
+                        ->num_children >= HALF)
+                    && (k+1 == self->num_children
+                        || ((PyBList *) self->children[k+1])
+                        ->num_children >= HALF)) {
+                        /* No underflow to repair; this is what
+                         * blist_underflow() would do, without visiting
+                         * every child to recompute self->n. */
+                        self->n -= self->sizes[k] - p->n;
+                        self->sizes[k] = p->n;
+                        self->sizes_valid = 1;
+                        return _int(0);
+                }
                 if (p->n == 0) {
                         SAFE_DECREF(p);
                         shift_left(self, k+1, 1);
@@ -2739,7 +3264,7 @@ static int blist_delslice(PyBList *self, Py_ssize_t i, Py_ssize_t j)
 BLIST_LOCAL(PyObject *)
 blist_get1(PyBList *self, Py_ssize_t i)
 {
-        PyBList *p;
+        PyObject *child;
         int k;
         Py_ssize_t so_far;
 
@@ -2748,9 +3273,9 @@ blist_get1(PyBList *self, Py_ssize_t i)
         if (self->leaf)
                 return _ob(self->children[i]);
 
-        blist_locate(self, i, (PyObject **) &p, &k, &so_far);
+        blist_locate(self, i, &child, &k, &so_far);
         assert(i >= so_far);
-        return _ob(blist_get1(p, i - so_far));
+        return _ob(blist_get1((PyBList *) child, i - so_far));
 }
 
 BLIST_LOCAL(PyObject *)
@@ -2765,6 +3290,8 @@ blist_pop_last_fast(PyBList *self)
                 if (p != self && Py_REFCNT(p) > 1)
                         goto cleanup_and_slow;
                 p->n--;
+                if (p->sizes_valid)
+                        p->sizes[p->num_children-1]--;
         }
 
         if ((Py_REFCNT(p) > 1 || p->num_children == HALF)
@@ -2772,8 +3299,11 @@ blist_pop_last_fast(PyBList *self)
                 PyBList *p2;
         cleanup_and_slow:
                 for (p2 = self; p != p2;
-                     p2 = (PyBList*)p2->children[p2->num_children-1])
+                     p2 = (PyBList*)p2->children[p2->num_children-1]) {
                         p2->n++;
+                        if (p2->sizes_valid)
+                                p2->sizes[p2->num_children-1]++;
+                }
                 return _ob(NULL);
         }
         p->n--;
@@ -2788,6 +3318,46 @@ blist_pop_last_fast(PyBList *self)
         return _ob(p->children[p->num_children]);
 }
 
+/* The mirror image of blist_pop_last_fast(), down the left spine.  Every
+ * position shifts, so the whole index is dirtied.  Returns NULL if a
+ * node on the spine is shared or the first leaf would underflow. */
+BLIST_LOCAL(PyObject *)
+blist_pop_first_fast(PyBList *self)
+{
+        PyBList *p;
+        PyObject *rv;
+
+        invariants(self, VALID_ROOT|VALID_RW);
+
+        for (p = self; !p->leaf; p = (PyBList*)p->children[0]) {
+                if (p != self && Py_REFCNT(p) > 1)
+                        goto cleanup_and_slow;
+                p->n--;
+                if (p->sizes_valid)
+                        p->sizes[0]--;
+        }
+
+        if ((Py_REFCNT(p) > 1 || p->num_children == HALF)
+            && self != p) {
+                PyBList *p2;
+        cleanup_and_slow:
+                for (p2 = self; p != p2;
+                     p2 = (PyBList*)p2->children[0]) {
+                        p2->n++;
+                        if (p2->sizes_valid)
+                                p2->sizes[0]++;
+                }
+                return _ob(NULL);
+        }
+        rv = p->children[0];
+        shift_left(p, 1, 1);
+        p->n--;
+        p->num_children--;
+
+        ext_mark(self, 0, DIRTY);
+        return _ob(rv);
+}
+
 static void blist_delitem(PyBList *self, Py_ssize_t i)
 {
         invariants(self, VALID_ROOT|VALID_RW);
@@ -2814,16 +3384,199 @@ static PyObject *blist_delitem_return(PyBList *self, Py_ssize_t i)
         return rv;
 }
 
-/************************************************************************
- * BList iterator
- */
-
-static iter_t *iter_init(iter_t *iter, PyBList *lst)
+/* Insert v just before position i of a root.  0 <= i <= self->n.
+ * Returns -1 if the root's children array could not be grown. */
+BLIST_LOCAL(int)
+blist_insert_root(PyBList *self, Py_ssize_t i, PyObject *v)
 {
-        iter->depth = 0;
+        PyBList *overflow;
 
-        while(!lst->leaf) {
-                iter->stack[iter->depth].lst = lst;
+        invariants(self, VALID_ROOT|VALID_RW);
+        assert(i >= 0 && i <= self->n);
+
+        /* Speed up the common case */
+        if (self->leaf && self->num_children < LIMIT) {
+                if (blist_root_reserve(self, self->num_children + 1) < 0)
+                        return _int(-1);
+
+                Py_INCREF(v);
+
+                shift_right(self, i, 1);
+                self->num_children++;
+                self->n++;
+                self->children[i] = v;
+                return _int(0);
+        }
+
+        overflow = ins1(self, i, v);
+        if (overflow) {
+                blist_overflow_root(self, overflow);
+                ext_mark(self, 0, DIRTY);
+        } else
+                ext_mark_moved(self, i, self->n - 1);
+        return _int(0);
+}
+
+/************************************************************************
+ * Searching sorted lists
+ */
+
+/* Return a new reference to the sort key of an item.  Keyed sorted
+ * containers store (key, value) pairs and order them by the key alone.
+ */
+BLIST_LOCAL_INLINE(PyObject *)
+bisect_key(PyObject *item, int keyed)
+{
+        if (!keyed) {
+                Py_INCREF(item);
+                return item;
+        }
+        if (PyTuple_CheckExact(item) && PyTuple_GET_SIZE(item) > 0) {
+                item = PyTuple_GET_ITEM(item, 0);
+                Py_INCREF(item);
+                return item;
+        }
+        return PySequence_GetItem(item, 0);
+}
+
+/* Return 1 if item belongs before the insertion point for key, 0 if
+ * not, or -1 on error.  For a left bisection the items before the
+ * point are those < key, for a right bisection those <= key.
+ */
+BLIST_LOCAL(int)
+bisect_before(PyObject *item, PyObject *key, int keyed, int right,
+              fast_compare_data_t fast_cmp_type)
+{
+        PyObject *item_key;
+        int c;
+
+        /* Hold our own reference, since the comparison may run
+         * arbitrary code that modifies the list */
+        item_key = bisect_key(item, keyed);
+        if (item_key == NULL)
+                return -1;
+        if (right) {
+                c = fast_lt(key, item_key, fast_cmp_type);
+                if (c >= 0)
+                        c = !c;
+        } else
+                c = fast_lt(item_key, key, fast_cmp_type);
+        decref_later(item_key);
+        return c;
+}
+
+/* Locate the insertion point for key in a list sorted in ascending
+ * order.  If right is false, the point lies before any items equal to
+ * key; otherwise, it lies after them.  Returns -1 on error.
+ *
+ * Rather than a binary search over positions, each of which would
+ * locate an item from the root, we descend the tree once.  At each
+ * node, we binary search the children by comparing key to the first
+ * item of each child's subtree.  That uses O(log n) comparisons, but
+ * finding each first item walks down to a leaf, so the search still
+ * takes O(log**2 n) operations.
+ *
+ * The comparisons may modify the list.  We hold a reference to the
+ * node we are searching so that any writes to it (other than the root)
+ * are copy-on-write, and we keep our positions within the bounds of
+ * the root.  The result is meaningless if the list changes, but the
+ * search is safe.
+ */
+static Py_ssize_t blist_bisect(PyBList *self, PyObject *key, int keyed,
+                               int right)
+{
+        PyBList *p = self;
+        Py_ssize_t offset = 0;
+        int lo, hi, mid, c, k;
+        fast_compare_data_t fast_cmp_type;
+
+        invariants(self, VALID_PARENT);
+
+        fast_cmp_type = check_fast_cmp_type(key, Py_LT);
+        Py_INCREF(p);
+
+        while (!p->leaf) {
+                PyBList *child;
+
+                /* Find the last child whose first item lies before the
+                 * insertion point.  The point may be at the end of that
+                 * child, but cannot be in any child to its right. */
+                lo = 1;
+                hi = p->num_children;
+                while (lo < hi) {
+                        PyObject *first;
+
+                        mid = (lo + hi) / 2;
+                        for (child = (PyBList *) p->children[mid];
+                             !child->leaf;
+                             child = (PyBList *) child->children[0])
+                                ;
+                        first = child->children[0];
+                        c = bisect_before(first, key, keyed, right,
+                                          fast_cmp_type);
+                        if (c < 0)
+                                goto error;
+                        if (c)
+                                lo = mid + 1;
+                        else
+                                hi = mid;
+                        if (p->leaf)
+                                break;
+                        if (hi > p->num_children)
+                                hi = p->num_children;
+                        if (lo > hi)
+                                lo = hi;
+                }
+                if (p->leaf)
+                        continue;
+
+                for (k = 0; k < lo - 1; k++)
+                        offset += ((PyBList *) p->children[k])->n;
+                child = (PyBList *) p->children[lo - 1];
+                Py_INCREF(child);
+                decref_later((PyObject *) p);
+                p = child;
+        }
+
+        lo = 0;
+        hi = p->num_children;
+        while (lo < hi) {
+                mid = (lo + hi) / 2;
+                c = bisect_before(p->children[mid], key, keyed, right,
+                                  fast_cmp_type);
+                if (c < 0)
+                        goto error;
+                if (c)
+                        lo = mid + 1;
+                else
+                        hi = mid;
+                if (hi > p->num_children)
+                        hi = p->num_children;
+                if (lo > hi)
+                        lo = hi;
+        }
+
+        offset += lo;
+        if (offset > self->n)
+                offset = self->n;
+        decref_later((PyObject *) p);
+        return _int(offset);
+
+ error:
+        decref_later((PyObject *) p);
+        return _int(-1);
+}
+
+/************************************************************************
+ * BList iterator
+ */
+
+static iter_t *iter_init(iter_t *iter, PyBList *lst)
+{
+        iter->depth = 0;
+
+        while(!lst->leaf) {
+                iter->stack[iter->depth].lst = lst;
                 iter->stack[iter->depth++].i = 1;
                 Py_INCREF(lst);
                 lst = (PyBList *) lst->children[0];
@@ -2844,10 +3597,12 @@ static iter_t *iter_init2(iter_t *iter, PyBList *lst, Py_ssize_t start)
         assert(start >= 0);
         while (!lst->leaf) {
                 PyBList *p;
+                PyObject *child;
                 int k;
                 Py_ssize_t so_far;
 
-                blist_locate(lst, start, (PyObject **) &p, &k, &so_far);
+                blist_locate(lst, start, &child, &k, &so_far);
+                p = (PyBList *) child;
                 iter->stack[iter->depth].lst = lst;
                 iter->stack[iter->depth++].i = k + 1;
                 Py_INCREF(lst);
@@ -2863,6 +3618,38 @@ static iter_t *iter_init2(iter_t *iter, PyBList *lst, Py_ssize_t start)
         return iter;
 }
 
+/* Called on entering a new leaf, going forward if dir is 1 and backward
+ * if it is -1.  Prefetches the leaf's first few items, the array of
+ * children of the sibling leaf that comes next and the node of the one
+ * after that.  That node is then in cache for the following call. */
+BLIST_LOCAL_INLINE(void)
+iter_prefetch_leaf(iter_t *iter, int dir)
+{
+#if BLIST_PREFETCH_DISTANCE > 0
+        PyBList *p = iter->leaf;
+        PyBList *parent;
+        int j, k;
+
+        for (j = 0; j < BLIST_PREFETCH_DISTANCE; j++) {
+                k = iter->i + dir * j;
+                if (k < 0 || k >= p->num_children)
+                        break;
+                BLIST_PREFETCH(p->children[k]);
+        }
+
+        if (iter->depth < 2)
+                return;
+        parent = iter->stack[iter->depth-2].lst;
+        k = iter->stack[iter->depth-2].i;
+        if (k < 0 || k >= parent->num_children)
+                return;
+        BLIST_PREFETCH(((PyBList *) parent->children[k])->children);
+        k += dir;
+        if (k >= 0 && k < parent->num_children)
+                BLIST_PREFETCH(parent->children[k]);
+#endif
+}
+
 static PyObject *iter_next(iter_t *iter)
 {
         PyBList *p;
@@ -2882,8 +3669,10 @@ static PyObject *iter_next(iter_t *iter)
                 return NULL;
         }
 
-        if (iter->i < p->num_children)
+        if (iter->i < p->num_children) {
+                PREFETCH_AHEAD(p, iter->i);
                 return p->children[iter->i++];
+        }
 
         iter->depth--;
         do {
@@ -2909,6 +3698,7 @@ static PyObject *iter_next(iter_t *iter)
 
         iter->leaf = iter->stack[iter->depth-1].lst;
         iter->i = iter->stack[iter->depth-1].i;
+        iter_prefetch_leaf(iter, 1);
 
         return p->children[i];
 }
@@ -2954,8 +3744,10 @@ py_blist_iter(PyObject *oseq)
                 it->iter.i = 0;
                 it->iter.depth = 1;
                 Py_INCREF(seq);
-        } else
+        } else {
+                ext_note_idle((PyBListRoot *) seq);
                 iter_init(&it->iter, seq);
+        }
 
         PyObject_GC_Track(it);
         return _ob((PyObject *) it);
@@ -3004,6 +3796,7 @@ static PyObject *blistiter_next(PyObject *oit)
         if (p == NULL)
                 return NULL;
         if (p->leaf && it->iter.i < p->num_children) {
+                PREFETCH_AHEAD(p, it->iter.i);
                 obj = p->children[it->iter.i++];
                 Py_INCREF(obj);
                 return obj;
@@ -3100,10 +3893,12 @@ riter_init2(iter_t *iter, PyBList *lst, Py_ssize_t start, Py_ssize_t stop)
         assert(start >= stop);
         while (!lst->leaf) {
                 PyBList *p;
+                PyObject *child;
                 int k;
                 Py_ssize_t so_far;
 
-                blist_locate(lst, start-1, (PyObject **) &p, &k, &so_far);
+                blist_locate(lst, start-1, &child, &k, &so_far);
+                p = (PyBList *) child;
                 iter->stack[iter->depth].lst = lst;
                 iter->stack[iter->depth++].i = k - 1;
                 Py_INCREF(lst);
@@ -3143,8 +3938,10 @@ iter_prev(iter_t *iter)
         if (iter->i >= p->num_children && iter->i >= 0)
                 iter->i = p->num_children - 1;
 
-        if (iter->i >= 0)
+        if (iter->i >= 0) {
+                PREFETCH_BEHIND(p, iter->i);
                 return p->children[iter->i--];
+        }
 
         iter->depth--;
         do {
@@ -3173,6 +3970,7 @@ iter_prev(iter_t *iter)
 
         iter->leaf = iter->stack[iter->depth-1].lst;
         iter->i = iter->stack[iter->depth-1].i;
+        iter_prefetch_leaf(iter, -1);
 
         return p->children[i];
 }
@@ -3197,8 +3995,10 @@ py_blist_reversed(PyBList *seq)
                 it->iter.i = seq->n-1;
                 it->iter.depth = 1;
                 Py_INCREF(seq);
-        } else
+        } else {
+                ext_note_idle((PyBListRoot *) seq);
                 riter_init(&it->iter, seq);
+        }
 
         PyObject_GC_Track(it);
         return _ob((PyObject *) it);
@@ -3219,6 +4019,7 @@ static PyObject *blistiter_prev(PyObject *oit)
                 it->iter.i = p->num_children - 1;
 
         if (p->leaf && it->iter.i >= 0) {
+                PREFETCH_BEHIND(p, it->iter.i);
                 obj = p->children[it->iter.i--];
                 Py_INCREF(obj);
                 return obj;
@@ -3295,6 +4096,113 @@ PyTypeObject PyBListReverseIter_Type = {
         0,                                      /* tp_members */
 };
 
+/************************************************************************
+ * BList chunk iterator
+ *
+ * Yields the items of each leaf in turn as one tuple, so that bulk
+ * consumers pay the per-call overhead once per leaf instead of once
+ * per item.
+ */
+
+BLIST_PYAPI(PyObject *)
+py_blist_iter_chunks(PyBList *seq)
+{
+        blistiterobject *it;
+
+        invariants(seq, VALID_USER);
+
+        DANGER_BEGIN;
+        it = PyObject_GC_New(blistiterobject, &PyBListChunkIter_Type);
+        DANGER_END;
+        if (it == NULL)
+                return _ob(NULL);
+
+        if (seq->leaf) {
+                it->iter.leaf = seq;
+                it->iter.i = 0;
+                it->iter.depth = 1;
+                Py_INCREF(seq);
+        } else {
+                ext_note_idle((PyBListRoot *) seq);
+                iter_init(&it->iter, seq);
+        }
+
+        PyObject_GC_Track(it);
+        return _ob((PyObject *) it);
+}
+
+static PyObject *blistchunkiter_next(PyObject *oit)
+{
+        blistiterobject *it = (blistiterobject *) oit;
+        PyObject *rv;
+        PyBList *p;
+        int i, k;
+
+        p = it->iter.leaf;
+        if (p == NULL || !p->leaf)
+                return NULL;
+
+        if (it->iter.i >= p->num_children) {
+                /* iter_next() steps to the next leaf and consumes its
+                 * first item; take the whole leaf instead. */
+                if (iter_next(&it->iter) == NULL) {
+                        _decref_flush();
+                        return NULL;
+                }
+                p = it->iter.leaf;
+                it->iter.i = 0;
+        }
+
+        i = it->iter.i;
+        k = p->num_children - i;
+        rv = PyTuple_New(k);
+        if (rv == NULL) {
+                _decref_flush();
+                return NULL;
+        }
+        it->iter.i = p->num_children;
+        for (k = 0; i < p->num_children; i++, k++) {
+                Py_INCREF(p->children[i]);
+                PyTuple_SET_ITEM(rv, k, p->children[i]);
+        }
+
+        _decref_flush();
+        return rv;
+}
+
+PyTypeObject PyBListChunkIter_Type = {
+        PyVarObject_HEAD_INIT(NULL, 0)
+        "blistchunkiterator",                   /* tp_name */
+        sizeof(blistiterobject),                /* tp_basicsize */
+        0,                                      /* tp_itemsize */
+        /* methods */
+        blistiter_dealloc,                      /* tp_dealloc */
+        0,                                      /* tp_print */
+        0,                                      /* tp_getattr */
+        0,                                      /* tp_setattr */
+        0,                                      /* tp_compare */
+        0,                                      /* tp_repr */
+        0,                                      /* tp_as_number */
+        0,                                      /* tp_as_sequence */
+        0,                                      /* tp_as_mapping */
+        0,                                      /* tp_hash */
+        0,                                      /* tp_call */
+        0,                                      /* tp_str */
+        PyObject_GenericGetAttr,                /* tp_getattro */
+        0,                                      /* tp_setattro */
+        0,                                      /* tp_as_buffer */
+        Py_TPFLAGS_DEFAULT | Py_TPFLAGS_HAVE_GC,/* tp_flags */
+        0,                                      /* tp_doc */
+        blistiter_traverse,                     /* tp_traverse */
+        0,                                      /* tp_clear */
+        0,                                      /* tp_richcompare */
+        0,                                      /* tp_weaklistoffset */
+        PyObject_SelfIter,                      /* tp_iter */
+        blistchunkiter_next,                    /* tp_iternext */
+        0,                                      /* tp_methods */
+        0,                                      /* tp_members */
+};
+
 /************************************************************************
  * A forest is an array of BList tree structures, which may be of
  * different heights.  It's a temporary utility structure for certain
@@ -3634,6 +4542,9 @@ blist_init_from_array(PyBList *self, PyObject **restrict src, Py_ssize_t n)
 
         invariants(self, VALID_ROOT|VALID_RW);
 
+        if (blist_root_reserve(self, n) < 0)
+                return _int(-1);
+
         if (n <= LIMIT) {
                 dst = self->children;
                 while (src < stop) {
@@ -3713,6 +4624,9 @@ blist_init_from_seq(PyBList *self, PyObject *b)
 
         if (PyBList_Check(b)) {
                 /* We can copy other BLists in O(1) time :-) */
+                if (blist_root_reserve(self, ((PyBList *) b)->leaf
+                                       ? ((PyBList *) b)->n : LIMIT) < 0)
+                        return _int(-1);
                 blist_become(self, (PyBList *) b);
                 ext_mark(self, 0, DIRTY);
                 ext_mark_set_dirty_all((PyBList *) b);
@@ -3759,6 +4673,10 @@ blist_init_from_seq(PyBList *self, PyObject *b)
                         goto done;
                 }
 
+                if (blist_root_reserve(self, self->num_children + 1) < 0) {
+                        decref_later(item);
+                        goto error;
+                }
                 self->children[self->num_children] = item;
         }
 
@@ -3876,13 +4794,15 @@ ext_make_clean_set(PyBListRoot *root, Py_ssize_t i, PyObject *v)
 {
         PyBList *p = (PyBList *) root;
         PyBList *next;
+        PyObject *child;
         int k;
         Py_ssize_t so_far, offset = 0;
         PyObject *old_value;
         int did_mark = 0;
 
         while (!p->leaf) {
-                blist_locate(p, i, (PyObject **) &next, &k, &so_far);
+                blist_locate(p, i, &child, &k, &so_far);
+                next = (PyBList *) child;
                 if (Py_REFCNT(next) <= 1)
                         p = next;
                 else {
@@ -3897,8 +4817,11 @@ ext_make_clean_set(PyBListRoot *root, Py_ssize_t i, PyObject *v)
                 offset += so_far;
         }
 
-        if (!root->leaf)
-                ext_mark_clean(root, offset, p, 1);
+        if (!root->leaf) {
+                if (EXT_INDEXED(root))
+                        ext_mark_clean(root, offset, p, 1);
+                ext_set_finger(root, p, offset, 1);
+        }
 
         old_value = p->children[i];
         p->children[i] = v;
@@ -3915,7 +4838,15 @@ blist_ass_item_return_slow(PyBListRoot *root, Py_ssize_t i, PyObject *v)
         invariants(root, VALID_RW);
         ioffset = i / INDEX_FACTOR;
 
-        if (root->leaf || ext_is_dirty(root, i, &dirty_offset)
+        if (!root->leaf && root->finger_rw && EXT_FINGER_HAS(root, i)) {
+                PyBList *p = root->finger;
+                rv = p->children[i - root->finger_offset];
+                p->children[i - root->finger_offset] = v;
+                return _ob(rv);
+        }
+
+        if (root->leaf || !ext_want_index(root)
+            || ext_is_dirty(root, i, &dirty_offset)
             || !GET_BIT(root->setclean_list, ioffset)) {
                 rv = ext_make_clean_set(root, i, v);
         } else {
@@ -3939,7 +4870,7 @@ blist_ass_item_return_slow(PyBListRoot *root, Py_ssize_t i, PyObject *v)
                         rv = p->children[i - offset];
                         p->children[i - offset] = v;
                         if (dirty_offset >= 0)
-                                ext_make_clean(root, dirty_offset);
+                                ext_make_clean(root, dirty_offset, 0);
                 } else if (ext_is_dirty(root,i + INDEX_FACTOR,&dirty_offset)
                         || !GET_BIT(root->setclean_list, ioffset+1)) {
                         rv = ext_make_clean_set(root, i, v);
@@ -4284,6 +5215,12 @@ blist_repeat(PyBList *self, Py_ssize_t n)
         if (rv == NULL)
                 return _ob(NULL);
 
+        if (n == 1 || self->num_children > HALF) {
+                if (blist_root_reserve(rv, self->leaf ? self->n * n
+                                       : LIMIT) < 0)
+                        goto error_rv;
+        }
+
         if (n == 1) {
                 blist_become(rv, self);
                 ext_mark(rv, 0, DIRTY);
@@ -4295,10 +5232,13 @@ blist_repeat(PyBList *self, Py_ssize_t n)
         else {
                 Py_ssize_t fit, fitn, so_far;
 
-                rv->leaf = self->leaf;
                 fit = LIMIT / self->num_children;
                 if (fit > n) fit = n;
                 fitn = fit * self->num_children;
+                if (blist_root_reserve(rv, self->leaf && fit == n
+                                       ? fitn : LIMIT) < 0)
+                        goto error_rv;
+                rv->leaf = self->leaf;
                 xcopyref(rv, 0, self, 0, self->num_children);
                 so_far = self->num_children;
                 while (so_far*2 < fitn) {
@@ -4322,7 +5262,11 @@ blist_repeat(PyBList *self, Py_ssize_t n)
                 if (remainder_n) {
                         remainder = blist_root_new();
                         if (remainder == NULL)
-                                goto error;
+                                goto error_rv;
+                        if (blist_root_reserve(remainder, LIMIT) < 0) {
+                                SAFE_DECREF(remainder);
+                                goto error_rv;
+                        }
                         remainder->n = self->n * remainder_n;
                         remainder_n *= self->num_children;
                         remainder->leaf = self->leaf;
@@ -4337,9 +5281,9 @@ blist_repeat(PyBList *self, Py_ssize_t n)
 
         power = rv;
         rv = blist_root_new();
-        if (rv == NULL) {
+        if (rv == NULL || blist_root_reserve(rv, LIMIT) < 0) {
+                SAFE_XDECREF(rv);
                 SAFE_XDECREF(remainder);
-        error:
                 SAFE_DECREF(power);
                 return _ob(NULL);
         }
@@ -4364,6 +5308,10 @@ blist_repeat(PyBList *self, Py_ssize_t n)
         check_invariants(rv);
         ext_mark(rv, 0, DIRTY);
         return _ob((PyObject *) rv);
+
+ error_rv:
+        SAFE_DECREF(rv);
+        return _ob(NULL);
 }
 
 BLIST_LOCAL(void)
@@ -4404,13 +5352,13 @@ linearize_rw(PyBListRoot *self)
 
 slow:
         linearize_rw_r((PyBList *)self);
-        ext_reindex_set_all(self);
+        _ext_reindex_all(self, 1); /* Needed even if !EXT_INDEXED(self) */
 }
 
 BLIST_LOCAL(void)
 blist_reverse(PyBListRoot *restrict self)
 {
-        int idx, ridx;
+        int idx, ridx, last;
         PyBList *restrict left, *restrict right;
         register PyObject **restrict slice1;
         register PyObject **restrict slice2;
@@ -4427,16 +5375,19 @@ blist_reverse(PyBListRoot *restrict self)
 
         linearize_rw(self);
 
+        /* A leaf may fill several slots of the index; step past its
+         * duplicates without reading outside the index */
+        last = INDEX_LENGTH(self)-1;
         idx = 0;
         left = self->index_list[idx];
-        if (left == self->index_list[idx+1])
+        if (idx < last && left == self->index_list[idx+1])
                 idx++;
         slice1 = &left->children[0];
         n1 = left->num_children;
 
-        ridx = INDEX_LENGTH(self)-1;
+        ridx = last;
         right = self->index_list[ridx];
-        if (right == self->index_list[ridx-1])
+        if (ridx > 0 && right == self->index_list[ridx-1])
                 ridx--;
         slice2 = &right->children[right->num_children-1];
         n2 = right->num_children;
@@ -4485,7 +5436,7 @@ blist_reverse(PyBListRoot *restrict self)
                 if (!n1) {
                         idx++;
                         left = self->index_list[idx];
-                        if (left == self->index_list[idx+1])
+                        if (idx < last && left == self->index_list[idx+1])
                                 idx++;
                         slice1 = &left->children[0];
                         n1 = left->num_children;
@@ -4495,7 +5446,8 @@ blist_reverse(PyBListRoot *restrict self)
                 if (!n2) {
                         ridx--;
                         right = self->index_list[ridx];
-                        if (right == self->index_list[ridx-1])
+                        if (ridx > 0
+                            && right == self->index_list[ridx-1])
                                 ridx--;
                         slice2 = &right->children[right->num_children-1];
                         n2 = right->num_children;
@@ -4527,17 +5479,24 @@ blist_append(PyBList *self, PyObject *v)
                 if (p != self && Py_REFCNT(p) > 1)
                         goto cleanup_and_slow;
                 p->n++;
+                if (p->sizes_valid)
+                        p->sizes[p->num_children-1]++;
         }
 
         if (p->num_children == LIMIT || (p != self && Py_REFCNT(p) > 1)) {
                 PyBList *p2;
         cleanup_and_slow:
                 for (p2 = self; p2 != p;
-                     p2 = (PyBList*)p2->children[p2->num_children-1])
+                     p2 = (PyBList*)p2->children[p2->num_children-1]) {
                         p2->n--;
+                        if (p2->sizes_valid)
+                                p2->sizes[p2->num_children-1]--;
+                }
                 goto slow;
         }
 
+        if (p == self && blist_root_reserve(self, self->num_children+1) < 0)
+                return _int(-1);
         p->children[p->num_children++] = v;
         p->n++;
         Py_INCREF(v);
@@ -4560,6 +5519,51 @@ blist_append(PyBList *self, PyObject *v)
         return _int(0);
 }
 
+/* The mirror image of blist_append(), down the left spine */
+BLIST_LOCAL(int)
+blist_appendleft(PyBList *self, PyObject *v)
+{
+        PyBList *p;
+
+        invariants(self, VALID_ROOT|VALID_RW);
+
+        if (self->n == PY_SSIZE_T_MAX) {
+                PyErr_SetString(PyExc_OverflowError,
+                                "cannot add more objects to list");
+                return _int(-1);
+        }
+
+        for (p = self; !p->leaf; p = (PyBList*)p->children[0]) {
+                if (p != self && Py_REFCNT(p) > 1)
+                        goto cleanup_and_slow;
+                p->n++;
+                if (p->sizes_valid)
+                        p->sizes[0]++;
+        }
+
+        if (p->num_children == LIMIT || (p != self && Py_REFCNT(p) > 1)) {
+                PyBList *p2;
+        cleanup_and_slow:
+                for (p2 = self; p2 != p; p2 = (PyBList*)p2->children[0]) {
+                        p2->n--;
+                        if (p2->sizes_valid)
+                                p2->sizes[0]--;
+                }
+                return _int(blist_insert_root(self, 0, v));
+        }
+
+        if (p == self && blist_root_reserve(self, self->num_children+1) < 0)
+                return _int(-1);
+        shift_right(p, 0, 1);
+        p->children[0] = v;
+        p->num_children++;
+        p->n++;
+        Py_INCREF(v);
+
+        ext_mark(self, 0, DIRTY);
+        return _int(0);
+}
+
 /************************************************************************
  * Sorting code
  *
@@ -4593,36 +5597,449 @@ unwrap_leaf_array(PyBList **leafs, int leafs_n, int n,
         }
 }
 
-#define KEY_ALL_DOUBLE 1
-#define KEY_ALL_LONG 2
+/* Sort key functions.  When the key function is an operator.itemgetter
+ * or attrgetter, we pull out its arguments and fetch the fields
+ * directly, saving a call per item.
+ */
 
-static int
-wrap_leaf_array(sortwrapperobject *restrict array,
-                PyBList **leafs, int leafs_n, int n,
-                PyObject *restrict keyfunc,
-                int *restrict pkey_flags)
-{
-        int i, j, k;
-        int key_flags;
+#define KEYFUNC_CALL 0
+#define KEYFUNC_ITEM 1
+#define KEYFUNC_ATTR 2
 
-        key_flags = KEY_ALL_DOUBLE | KEY_ALL_LONG;
+typedef struct keyfunc {
+        PyObject *func;
+        int kind;
+        PyObject *args;         /* Items, or tuples of attribute names */
+} keyfunc_t;
 
-        for (k = i = 0; i < leafs_n; i++) {
-                PyBList *restrict leaf = leafs[i];
-                if (leafs_n > 1)
-                        PyObject_GC_UnTrack(leaf);
+#if PY_VERSION_HEX >= 0x03050000
+static PyTypeObject *itemgetter_type = NULL;
+static PyTypeObject *attrgetter_type = NULL;
 
-                for (j = 0; j < leaf->num_children; j++) {
-                        sortwrapperobject *restrict pair = &array[k];
-                        PyObject *restrict key, *value = leaf->children[j];
-                        PyTypeObject *type;
-                        if (keyfunc == NULL) {
-                                key = value;
+static void
+getter_types_init(void)
+{
+        static int initialized = 0;
+        PyObject *operator, *zero, *getter;
+
+        if (initialized)
+                return;
+        initialized = 1;
+
+        operator = PyImport_ImportModule("operator");
+        if (operator == NULL) {
+                PyErr_Clear();
+                return;
+        }
+        zero = PyLong_FromLong(0);
+        getter = zero ? PyObject_CallMethod(operator, "itemgetter", "O", zero)
+                : NULL;
+        if (getter != NULL) {
+                itemgetter_type = Py_TYPE(getter);
+                Py_INCREF(itemgetter_type);
+                Py_DECREF(getter);
+        }
+        getter = PyObject_CallMethod(operator, "attrgetter", "s", "x");
+        if (getter != NULL) {
+                attrgetter_type = Py_TYPE(getter);
+                Py_INCREF(attrgetter_type);
+                Py_DECREF(getter);
+        }
+        PyErr_Clear();
+        Py_XDECREF(zero);
+        Py_DECREF(operator);
+}
+
+/* Returns the arguments of a getter as a new tuple, or NULL */
+static PyObject *
+getter_args(PyObject *getter)
+{
+        PyObject *reduced, *args = NULL;
+
+        reduced = PyObject_CallMethod(getter, "__reduce__", NULL);
+        if (reduced != NULL && PyTuple_Check(reduced)
+            && PyTuple_GET_SIZE(reduced) == 2
+            && PyTuple_GET_ITEM(reduced, 0) == (PyObject *) Py_TYPE(getter)
+            && PyTuple_CheckExact(PyTuple_GET_ITEM(reduced, 1))
+            && PyTuple_GET_SIZE(PyTuple_GET_ITEM(reduced, 1)) > 0) {
+                args = PyTuple_GET_ITEM(reduced, 1);
+                Py_INCREF(args);
+        }
+        Py_XDECREF(reduced);
+        PyErr_Clear();
+        return args;
+}
+
+/* Split each dotted attribute name into a tuple of names */
+static PyObject *
+split_attr_names(PyObject *attrs)
+{
+        Py_ssize_t i, n = PyTuple_GET_SIZE(attrs);
+        PyObject *dot, *names;
+
+        dot = PyUnicode_FromString(".");
+        names = PyTuple_New(n);
+        if (dot == NULL || names == NULL)
+                goto error;
+        for (i = 0; i < n; i++) {
+                PyObject *parts, *attr = PyTuple_GET_ITEM(attrs, i);
+                if (!PyUnicode_CheckExact(attr))
+                        goto error;
+                parts = PyUnicode_Split(attr, dot, -1);
+                if (parts == NULL)
+                        goto error;
+                PyTuple_SET_ITEM(names, i, PyList_AsTuple(parts));
+                Py_DECREF(parts);
+                if (PyTuple_GET_ITEM(names, i) == NULL)
+                        goto error;
+        }
+        Py_DECREF(dot);
+        return names;
+
+ error:
+        PyErr_Clear();
+        Py_XDECREF(dot);
+        Py_XDECREF(names);
+        return NULL;
+}
+#endif
+
+static void
+keyfunc_init(keyfunc_t *kf, PyObject *func)
+{
+        kf->func = func;
+        kf->kind = KEYFUNC_CALL;
+        kf->args = NULL;
+
+#if PY_VERSION_HEX >= 0x03050000
+        if (func == NULL)
+                return;
+        getter_types_init();
+        if (Py_TYPE(func) == itemgetter_type) {
+                kf->args = getter_args(func);
+                if (kf->args != NULL)
+                        kf->kind = KEYFUNC_ITEM;
+        } else if (Py_TYPE(func) == attrgetter_type) {
+                PyObject *attrs = getter_args(func);
+                if (attrs != NULL) {
+                        kf->args = split_attr_names(attrs);
+                        Py_DECREF(attrs);
+                }
+                if (kf->args != NULL)
+                        kf->kind = KEYFUNC_ATTR;
+        }
+#endif
+}
+
+static void
+keyfunc_release(keyfunc_t *kf)
+{
+        PyObject *args = kf->args;
+
+        kf->args = NULL;
+        DANGER_BEGIN;
+        Py_XDECREF(args);
+        DANGER_END;
+}
+
+#if PY_VERSION_HEX >= 0x03050000
+/* ob[item], without a call for the common containers */
+BLIST_LOCAL_INLINE(PyObject *)
+getitem_fast(PyObject *ob, PyObject *item)
+{
+        PyObject *v;
+
+        if ((PyTuple_CheckExact(ob) || PyList_CheckExact(ob))
+            && PyLong_CheckExact(item)) {
+                Py_ssize_t i = PyLong_AsSsize_t(item);
+                if (i == -1 && PyErr_Occurred())
+                        PyErr_Clear();
+                else {
+                        if (i < 0)
+                                i += Py_SIZE(ob);
+                        if (i >= 0 && i < Py_SIZE(ob)) {
+                                v = PyTuple_CheckExact(ob)
+                                        ? PyTuple_GET_ITEM(ob, i)
+                                        : PyList_GET_ITEM(ob, i);
+                                Py_INCREF(v);
+                                return v;
+                        }
+                }
+        } else if (PyDict_CheckExact(ob)) {
+                v = PyDict_GetItemWithError(ob, item);
+                if (v != NULL) {
+                        Py_INCREF(v);
+                        return v;
+                }
+                if (PyErr_Occurred())
+                        return NULL;
+        }
+
+        return PyObject_GetItem(ob, item);
+}
+
+BLIST_LOCAL_INLINE(PyObject *)
+getattrs(PyObject *ob, PyObject *names)
+{
+        Py_ssize_t i, n = PyTuple_GET_SIZE(names);
+
+        Py_INCREF(ob);
+        for (i = 0; i < n && ob != NULL; i++) {
+                PyObject *next = PyObject_GetAttr(
+                        ob, PyTuple_GET_ITEM(names, i));
+                Py_DECREF(ob);
+                ob = next;
+        }
+
+        return ob;
+}
+
+BLIST_LOCAL_INLINE(PyObject *)
+getter_field(keyfunc_t *kf, PyObject *value, Py_ssize_t i)
+{
+        PyObject *arg = PyTuple_GET_ITEM(kf->args, i);
+
+        if (kf->kind == KEYFUNC_ITEM)
+                return getitem_fast(value, arg);
+        return getattrs(value, arg);
+}
+#endif
+
+/* Returns a new reference to the key of value, or NULL on error */
+BLIST_LOCAL_INLINE(PyObject *)
+keyfunc_call(keyfunc_t *kf, PyObject *value)
+{
+#if PY_VERSION_HEX >= 0x03050000
+        if (kf->kind != KEYFUNC_CALL) {
+                Py_ssize_t i, n = PyTuple_GET_SIZE(kf->args);
+                PyObject *key;
+
+                if (n == 1)
+                        return getter_field(kf, value, 0);
+                key = PyTuple_New(n);
+                if (key == NULL)
+                        return NULL;
+                for (i = 0; i < n; i++) {
+                        PyObject *field = getter_field(kf, value, i);
+                        if (field == NULL) {
+                                Py_DECREF(key);
+                                return NULL;
+                        }
+                        PyTuple_SET_ITEM(key, i, field);
+                }
+                return key;
+        }
+#endif
+        return PyObject_CallFunctionObjArgs(kf->func, value, NULL);
+}
+
+#ifdef BLIST_FLOAT_RADIX_SORT
+/* Map a double to an unsigned 64-bit integer with the same ordering */
+BLIST_LOCAL_INLINE(PY_UINT64_T)
+double_key(double d)
+{
+        PY_UINT64_T di, mask;
+
+        if (d == 0.0)
+                d = 0.0;        /* -0.0 must tie with 0.0 */
+        memcpy(&di, &d, 8);
+        mask = (-(PY_INT64_T) (di >> 63)) | (1ull << 63ull);
+        return di ^ mask;
+}
+
+/* Returns 1 and stores the value of the int key in *d, if a double can
+ * hold it exactly.  Otherwise, returns 0. */
+static int
+long_as_exact_double(PyObject *key, double *d)
+{
+        PY_LONG_LONG v = PyLong_AsLongLong(key);
+        PyObject *back;
+        int exact;
+
+        if (v == -1 && PyErr_Occurred()) {
+                PyErr_Clear();
+                *d = PyLong_AsDouble(key);
+                if (*d == -1.0 && PyErr_Occurred()) {
+                        PyErr_Clear();
+                        return 0;
+                }
+                back = PyLong_FromDouble(*d);
+                if (back == NULL) {
+                        PyErr_Clear();
+                        return 0;
+                }
+                exact = PyObject_RichCompareBool(back, key, Py_EQ);
+                Py_DECREF(back);
+                if (exact < 0) {
+                        PyErr_Clear();
+                        return 0;
+                }
+                return exact;
+        }
+
+        *d = (double) v;
+        if (v >= -(1ll << 53) && v <= (1ll << 53))
+                return 1;
+        if (*d >= 9223372036854775808.0)
+                return 0;
+        return (PY_LONG_LONG) *d == v;
+}
+
+/* Re-encode a mix of int and float keys as doubles.  Returns 0 if some
+ * int has no exact double. */
+static int
+encode_numbers(sortwrapperobject *array, Py_ssize_t n)
+{
+        Py_ssize_t i;
+
+        for (i = 0; i < n; i++) {
+                PyObject *key = array[i].key;
+                double d;
+                if (Py_TYPE(key) == &PyFloat_Type)
+                        d = PyFloat_AS_DOUBLE(key);
+                else if (!long_as_exact_double(key, &d))
+                        return 0;
+                array[i].fkey.k_uint64 = double_key(d);
+        }
+
+        return 1;
+}
+#endif
+
+#ifdef BLIST_WIDE_RADIX_SORT
+static PyObject *sixty_four = NULL;
+
+/* Split an int into the high and low words of its 128-bit two's
+ * complement.  Returns 0 if it needs more bits, or -1 on error. */
+static int
+wide_long_split(PyObject *key, PY_INT64_T *hi, PY_UINT64_T *lo)
+{
+        PY_LONG_LONG v = PyLong_AsLongLong(key);
+        PyObject *shifted;
+
+        if (!(v == -1 && PyErr_Occurred())) {
+                *hi = v < 0 ? -1 : 0;
+                *lo = (PY_UINT64_T) v;
+                return 1;
+        }
+        if (!PyErr_ExceptionMatches(PyExc_OverflowError))
+                return -1;
+        PyErr_Clear();
+
+        if (sixty_four == NULL && (sixty_four = PyInt_FromLong(64)) == NULL)
+                return -1;
+        shifted = PyNumber_Rshift(key, sixty_four);
+        if (shifted == NULL)
+                return -1;
+        v = PyLong_AsLongLong(shifted);
+        Py_DECREF(shifted);
+        if (v == -1 && PyErr_Occurred()) {
+                if (!PyErr_ExceptionMatches(PyExc_OverflowError))
+                        return -1;
+                PyErr_Clear();
+                return 0;
+        }
+
+        *hi = v;
+        *lo = PyLong_AsUnsignedLongLongMask(key);
+        if (*lo == (PY_UINT64_T) -1 && PyErr_Occurred())
+                return -1;
+        return 1;
+}
+#endif
+
+#define KEY_ALL_DOUBLE 1
+#define KEY_ALL_LONG 2
+#define KEY_ALL_BYTES 4
+#define KEY_ALL_STR 8
+#define KEY_ALL_WIDE 16         /* All ints of at most 128 bits */
+#define KEY_ALL_NUMBER 32       /* All ints or floats */
+#define KEY_ALL_TUPLE 64
+
+/* Returns the key flags for an int too big for a long */
+static int
+big_long_flags(PyObject *key)
+{
+#ifdef BLIST_WIDE_RADIX_SORT
+        PY_INT64_T hi;
+        PY_UINT64_T lo;
+
+        if (wide_long_split(key, &hi, &lo) > 0)
+                return KEY_ALL_WIDE | KEY_ALL_NUMBER;
+        PyErr_Clear();
+#endif
+        return KEY_ALL_NUMBER;
+}
+
+/* Returns the key flags for one field of a tuple key */
+static int
+field_flags(PyObject *v)
+{
+#ifdef BLIST_FLOAT_RADIX_SORT
+        if (Py_TYPE(v) == &PyFloat_Type) {
+                double d = PyFloat_AS_DOUBLE(v);
+                if (d != d)
+                        return 0; /* NaNs break tuple ordering */
+                return KEY_ALL_DOUBLE | KEY_ALL_NUMBER;
+        }
+#endif
+#if PY_MAJOR_VERSION < 3
+        if (Py_TYPE(v) == &PyInt_Type)
+                return KEY_ALL_LONG | KEY_ALL_WIDE | KEY_ALL_NUMBER;
+#endif
+        if (Py_TYPE(v) == &PyLong_Type) {
+                long x = PyLong_AsLong(v);
+                if (x == -1 && PyErr_Occurred()) {
+                        PyErr_Clear();
+                        return big_long_flags(v);
+                }
+                return KEY_ALL_LONG | KEY_ALL_WIDE | KEY_ALL_NUMBER;
+        }
+#ifdef BLIST_WIDE_RADIX_SORT
+        if (Py_TYPE(v) == &PyBytes_Type)
+                return KEY_ALL_BYTES;
+#if PY_VERSION_HEX >= 0x03030000
+        if (Py_TYPE(v) == &PyUnicode_Type) {
+                if (PyUnicode_READY(v) < 0) {
+                        PyErr_Clear();
+                        return 0;
+                }
+                return KEY_ALL_STR;
+        }
+#endif
+#endif
+        return 0;
+}
+
+static int
+wrap_leaf_array(sortwrapperobject *restrict array,
+                PyBList **leafs, int leafs_n, int n,
+                keyfunc_t *restrict keyfunc, PyObject **keysrc,
+                int *restrict pkey_flags)
+{
+        int i, j, k;
+        int key_flags;
+
+        key_flags = KEY_ALL_DOUBLE | KEY_ALL_LONG | KEY_ALL_BYTES
+                | KEY_ALL_STR | KEY_ALL_WIDE | KEY_ALL_NUMBER
+                | KEY_ALL_TUPLE;
+
+        for (k = i = 0; i < leafs_n; i++) {
+                PyBList *restrict leaf = leafs[i];
+                if (leafs_n > 1)
+                        PyObject_GC_UnTrack(leaf);
+
+                for (j = 0; j < leaf->num_children; j++) {
+                        sortwrapperobject *restrict pair = &array[k];
+                        PyObject *restrict key, *value = leaf->children[j];
+                        PyObject *base = keysrc ? keysrc[k] : value;
+                        PyTypeObject *type;
+                        if (keyfunc == NULL) {
+                                key = base;
                                 Py_INCREF(key);
                         } else {
                                 DANGER_BEGIN;
-                                key = PyObject_CallFunctionObjArgs(
-                                        keyfunc, value, NULL);
+                                key = keyfunc_call(keyfunc, base);
                                 DANGER_END;
                                 if (key == NULL) {
                                         unwrap_leaf_array(leafs, leafs_n, k, array);
@@ -4632,13 +6049,9 @@ wrap_leaf_array(sortwrapperobject *restrict array,
                         type = key->ob_type;
 #ifdef BLIST_FLOAT_RADIX_SORT
                         if (type == &PyFloat_Type) {
-                                double d = PyFloat_AS_DOUBLE(key);
-                                PY_UINT64_T di, mask;
-                                memcpy(&di, &d, 8);
-                                mask = (-(PY_INT64_T) (di >> 63))
-                                        | (1ull << 63ull);
-                                pair->fkey.k_uint64 = di ^ mask;
-                                key_flags &= KEY_ALL_DOUBLE;
+                                pair->fkey.k_uint64 = double_key(
+                                        PyFloat_AS_DOUBLE(key));
+                                key_flags &= KEY_ALL_DOUBLE | KEY_ALL_NUMBER;
                         } else
 #endif
 #if PY_MAJOR_VERSION < 3
@@ -4647,7 +6060,8 @@ wrap_leaf_array(sortwrapperobject *restrict array,
                                 unsigned long u = i;
                                 const unsigned long mask = 1ul << (sizeof(long)*8-1);
                                 pair->fkey.k_ulong = u ^ mask;
-                                key_flags &= KEY_ALL_LONG;
+                                key_flags &= KEY_ALL_LONG | KEY_ALL_WIDE
+                                        | KEY_ALL_NUMBER;
                         } else
 #endif
                         if (type == &PyLong_Type) {
@@ -4655,13 +6069,31 @@ wrap_leaf_array(sortwrapperobject *restrict array,
                                 if (x == (unsigned long) (long) -1
                                     && PyErr_Occurred()) {
                                         PyErr_Clear();
-                                        key_flags = 0;
+                                        key_flags &= big_long_flags(key);
                                 } else {
                                         const unsigned long mask = 1ul << (sizeof(long)*8-1);
                                         pair->fkey.k_ulong = x ^ mask;
-                                        key_flags &= KEY_ALL_LONG;
+                                        key_flags &= KEY_ALL_LONG
+                                                | KEY_ALL_WIDE
+                                                | KEY_ALL_NUMBER;
                                 }
                         } else
+#ifdef BLIST_WIDE_RADIX_SORT
+                        if (type == &PyBytes_Type) {
+                                key_flags &= KEY_ALL_BYTES;
+                        } else if (type == &PyTuple_Type) {
+                                key_flags &= KEY_ALL_TUPLE;
+                        } else
+#if PY_VERSION_HEX >= 0x03030000
+                        if (type == &PyUnicode_Type) {
+                                if (PyUnicode_READY(key) < 0) {
+                                        PyErr_Clear();
+                                        key_flags = 0;
+                                } else
+                                        key_flags &= KEY_ALL_STR;
+                        } else
+#endif
+#endif
                                 key_flags = 0;
                         pair->key = key;
                         pair->value = value;
@@ -5361,72 +6793,316 @@ array_enable_GC(PyBList **leafs, Py_ssize_t num_leafs)
  */
 typedef Py_ssize_t histogram_array_t[NUM_PASSES];
 
-BLIST_LOCAL_INLINE(int)
-sort_ulong(sortwrapperobject *restrict sortarray, Py_ssize_t n)
-{
-        sortwrapperobject *restrict scratch, *from, *to, *tmp;
-        Py_ssize_t i, j, sums[NUM_PASSES], count[NUM_PASSES], tsum;
-        histogram_array_t *histograms;
+/* Large radix sorts release the GIL, since they touch no Python objects,
+ * and split each pass across worker threads.  Each thread counts the
+ * digits in its own contiguous chunk of the array, and then scatters
+ * that chunk to the positions reserved for it.  Chunks claim their
+ * positions within each bucket in array order, so the sort stays stable.
+ */
 
-        memset(sums, 0, sizeof sums);
-        memset(count, 0, sizeof count);
+#ifndef PARALLEL_SORT_THRESHOLD
+#define PARALLEL_SORT_THRESHOLD (1 << 20)
+#endif
+/* Tests lower this to reach the threaded path on small lists */
+static Py_ssize_t parallel_sort_threshold = PARALLEL_SORT_THRESHOLD;
+#define PARALLEL_SORT_CHUNK (parallel_sort_threshold / 4) /* Minimum per thread */
+#define MAX_SORT_THREADS 16
+#ifndef BLIST_SORT_THREADS
+#define BLIST_SORT_THREADS 0    /* 0 means one per online CPU */
+#endif
 
-        scratch = PyMem_New(sortwrapperobject, n);
-        if (scratch == NULL)
-                return -1;
+typedef struct radix_task {
+        sortwrapperobject *from;
+        sortwrapperobject *to;
+        Py_ssize_t start, stop;
+        unsigned shift;
+        int wide;               /* Keys are k_uint64, not k_ulong */
+        Py_ssize_t histogram[HISTOGRAM_SIZE];
+        void (*func)(struct radix_task *);
+#ifdef WITH_THREAD
+        PyThread_type_lock done;
+#endif
+} radix_task_t;
 
-        histograms = PyMem_New(histogram_array_t, HISTOGRAM_SIZE);
-        if (histograms == NULL) {
-                PyMem_Free(scratch);
-                return -1;
-        }
-        memset(histograms, 0, sizeof(histogram_array_t) * HISTOGRAM_SIZE);
+static void radix_count(radix_task_t *task)
+{
+        Py_ssize_t i;
+        Py_ssize_t *restrict histogram = task->histogram;
+        const sortwrapperobject *restrict from = task->from;
+        const unsigned shift = task->shift;
 
-        for (i = 0; i < n; i++) {
-                unsigned long v = sortarray[i].fkey.k_ulong;
-                for (j = 0; j < NUM_PASSES; j++) {
-                        histograms[(v >> (BITS_PER_PASS * j)) & MASK][j]++;
-                }
-        }
+        memset(histogram, 0, sizeof task->histogram);
 
-        for (i = 0; i < HISTOGRAM_SIZE; i++) {
-                for (j = 0; j < NUM_PASSES; j++) {
-                        count[j] += !!histograms[i][j];
-                        tsum = histograms[i][j] + sums[j];
-                        histograms[i][j] = sums[j] - 1;
-                        sums[j] = tsum;
-                }
+#if defined(BLIST_FLOAT_RADIX_SORT) && SIZEOF_LONG != 8
+        if (task->wide) {
+                for (i = task->start; i < task->stop; i++)
+                        histogram[(from[i].fkey.k_uint64 >> shift) & MASK]++;
+                return;
         }
+#endif
+        for (i = task->start; i < task->stop; i++)
+                histogram[(from[i].fkey.k_ulong >> shift) & MASK]++;
+}
 
-        from = sortarray;
-        to = scratch;
-        for (j = 0; j < NUM_PASSES; j++) {
-                sortwrapperobject *restrict f = from;
-                sortwrapperobject *restrict t = to;
-                if (count[j] == 1) continue;
-                for (i = 0; i < n; i++) {
-                        unsigned long fi = f[i].fkey.k_ulong;
-                        Py_ssize_t pos = (fi >> (BITS_PER_PASS * j)) & MASK;
-                        pos = ++histograms[pos][j];
-                        t[pos].fkey.k_ulong = fi;
-                        t[pos].value = f[i].value;
-                }
+static void radix_scatter(radix_task_t *task)
+{
+        Py_ssize_t i, pos;
+        Py_ssize_t *restrict histogram = task->histogram;
+        const sortwrapperobject *restrict from = task->from;
+        sortwrapperobject *restrict to = task->to;
+        const unsigned shift = task->shift;
 
-                tmp = from;
-                from = to;
-                to = tmp;
+#if defined(BLIST_FLOAT_RADIX_SORT) && SIZEOF_LONG != 8
+        if (task->wide) {
+                for (i = task->start; i < task->stop; i++) {
+                        PY_UINT64_T fi = from[i].fkey.k_uint64;
+                        pos = histogram[(fi >> shift) & MASK]++;
+                        to[pos].fkey.k_uint64 = fi;
+                        to[pos].value = from[i].value;
+                }
+                return;
+        }
+#endif
+        for (i = task->start; i < task->stop; i++) {
+                unsigned long fi = from[i].fkey.k_ulong;
+                pos = histogram[(fi >> shift) & MASK]++;
+                to[pos].fkey.k_ulong = fi;
+                to[pos].value = from[i].value;
         }
+}
 
-        if (from != sortarray)
-                for (i = 0; i < n; i++)
-                        sortarray[i].value = scratch[i].value;
+#ifdef WITH_THREAD
+static void radix_thread(void *arg)
+{
+        radix_task_t *task = (radix_task_t *) arg;
 
-        PyMem_Free(histograms);
-        PyMem_Free(scratch);
-        return 0;
+        task->func(task);
+        PyThread_release_lock(task->done);
 }
+#endif
 
-#undef NUM_PASSES
+/* Run func on every task, using a thread for each task after the first,
+ * and wait for them all to finish.  Called without the GIL. */
+static void
+radix_run(radix_task_t *tasks, int ntasks, void (*func)(radix_task_t *))
+{
+        int t;
+
+#ifdef WITH_THREAD
+        for (t = 1; t < ntasks; t++) {
+                tasks[t].func = func;
+                PyThread_acquire_lock(tasks[t].done, NOWAIT_LOCK);
+                if ((long) PyThread_start_new_thread(radix_thread, &tasks[t])
+                    == -1)
+                        radix_thread(&tasks[t]);
+        }
+#endif
+
+        func(&tasks[0]);
+
+#ifdef WITH_THREAD
+        for (t = 1; t < ntasks; t++) {
+                PyThread_acquire_lock(tasks[t].done, WAIT_LOCK);
+                PyThread_release_lock(tasks[t].done);
+        }
+#else
+        for (t = 1; t < ntasks; t++)
+                func(&tasks[t]);
+#endif
+}
+
+static int sort_threads(Py_ssize_t n)
+{
+        static long cpus = 0;
+        long threads;
+
+        if (!cpus) {
+                cpus = BLIST_SORT_THREADS;
+#ifdef WITH_THREAD
+#if defined(_SC_NPROCESSORS_ONLN)
+                if (cpus <= 0)
+                        cpus = sysconf(_SC_NPROCESSORS_ONLN);
+#elif defined(MS_WINDOWS)
+                if (cpus <= 0 && getenv("NUMBER_OF_PROCESSORS"))
+                        cpus = atol(getenv("NUMBER_OF_PROCESSORS"));
+#endif
+#endif
+                if (cpus <= 0)
+                        cpus = 1;
+                if (cpus > MAX_SORT_THREADS)
+                        cpus = MAX_SORT_THREADS;
+        }
+
+        threads = n / PARALLEL_SORT_CHUNK;
+        if (threads > cpus)
+                threads = cpus;
+        if (threads < 1)
+                threads = 1;
+        return (int) threads;
+}
+
+/* Radix sort a large array of wrappers on their fkey, with passes digits
+ * of BITS_PER_PASS bits each.  If wide, fkey holds k_uint64.  Returns -1
+ * and sets an exception if out of memory.
+ */
+static int
+sort_parallel(sortwrapperobject *restrict sortarray, Py_ssize_t n,
+              int passes, int wide)
+{
+        sortwrapperobject *restrict scratch, *from, *to, *tmp;
+        radix_task_t *tasks;
+        int ntasks, t, j, b, err = 0;
+        Py_ssize_t i, sum, total;
+
+        ntasks = sort_threads(n);
+
+        scratch = PyMem_New(sortwrapperobject, n);
+        tasks = PyMem_New(radix_task_t, ntasks);
+        if (scratch == NULL || tasks == NULL) {
+                PyMem_Free(scratch);
+                PyMem_Free(tasks);
+                PyErr_NoMemory();
+                return -1;
+        }
+
+        for (t = 0; t < ntasks; t++) {
+                tasks[t].start = n * t / ntasks;
+                tasks[t].stop = n * (t+1) / ntasks;
+                tasks[t].wide = wide;
+#ifdef WITH_THREAD
+                tasks[t].done = NULL;
+                if (t && (tasks[t].done = PyThread_allocate_lock()) == NULL)
+                        err = -1;
+#endif
+        }
+        if (err < 0) {
+                PyErr_NoMemory();
+                goto done;
+        }
+
+        Py_BEGIN_ALLOW_THREADS
+
+        from = sortarray;
+        to = scratch;
+        for (j = 0; j < passes; j++) {
+                int skip = 0;
+
+                for (t = 0; t < ntasks; t++) {
+                        tasks[t].from = from;
+                        tasks[t].to = to;
+                        tasks[t].shift = BITS_PER_PASS * j;
+                }
+                radix_run(tasks, ntasks, radix_count);
+
+                /* Turn the counts into starting positions */
+                sum = 0;
+                for (b = 0; b < HISTOGRAM_SIZE; b++) {
+                        total = 0;
+                        for (t = 0; t < ntasks; t++) {
+                                Py_ssize_t count = tasks[t].histogram[b];
+                                tasks[t].histogram[b] = sum;
+                                sum += count;
+                                total += count;
+                        }
+                        if (total == n)
+                                skip = 1; /* Every key has this digit */
+                }
+                if (skip)
+                        continue;
+
+                radix_run(tasks, ntasks, radix_scatter);
+
+                tmp = from;
+                from = to;
+                to = tmp;
+        }
+
+        if (from != sortarray)
+                for (i = 0; i < n; i++)
+                        sortarray[i].value = scratch[i].value;
+
+        Py_END_ALLOW_THREADS
+
+ done:
+#ifdef WITH_THREAD
+        for (t = 1; t < ntasks; t++)
+                if (tasks[t].done)
+                        PyThread_free_lock(tasks[t].done);
+#endif
+        PyMem_Free(tasks);
+        PyMem_Free(scratch);
+        return err;
+}
+
+BLIST_LOCAL_INLINE(int)
+sort_ulong(sortwrapperobject *restrict sortarray, Py_ssize_t n)
+{
+        sortwrapperobject *restrict scratch, *from, *to, *tmp;
+        Py_ssize_t i, j, sums[NUM_PASSES], count[NUM_PASSES], tsum;
+        histogram_array_t *histograms;
+
+        if (n >= parallel_sort_threshold)
+                return sort_parallel(sortarray, n, NUM_PASSES, 0);
+
+        memset(sums, 0, sizeof sums);
+        memset(count, 0, sizeof count);
+
+        scratch = PyMem_New(sortwrapperobject, n);
+        if (scratch == NULL)
+                return -1;
+
+        histograms = PyMem_New(histogram_array_t, HISTOGRAM_SIZE);
+        if (histograms == NULL) {
+                PyMem_Free(scratch);
+                return -1;
+        }
+        memset(histograms, 0, sizeof(histogram_array_t) * HISTOGRAM_SIZE);
+
+        for (i = 0; i < n; i++) {
+                unsigned long v = sortarray[i].fkey.k_ulong;
+                for (j = 0; j < NUM_PASSES; j++) {
+                        histograms[(v >> (BITS_PER_PASS * j)) & MASK][j]++;
+                }
+        }
+
+        for (i = 0; i < HISTOGRAM_SIZE; i++) {
+                for (j = 0; j < NUM_PASSES; j++) {
+                        count[j] += !!histograms[i][j];
+                        tsum = histograms[i][j] + sums[j];
+                        histograms[i][j] = sums[j] - 1;
+                        sums[j] = tsum;
+                }
+        }
+
+        from = sortarray;
+        to = scratch;
+        for (j = 0; j < NUM_PASSES; j++) {
+                sortwrapperobject *restrict f = from;
+                sortwrapperobject *restrict t = to;
+                if (count[j] == 1) continue;
+                for (i = 0; i < n; i++) {
+                        unsigned long fi = f[i].fkey.k_ulong;
+                        Py_ssize_t pos = (fi >> (BITS_PER_PASS * j)) & MASK;
+                        pos = ++histograms[pos][j];
+                        t[pos].fkey.k_ulong = fi;
+                        t[pos].value = f[i].value;
+                }
+
+                tmp = from;
+                from = to;
+                to = tmp;
+        }
+
+        if (from != sortarray)
+                for (i = 0; i < n; i++)
+                        sortarray[i].value = scratch[i].value;
+
+        PyMem_Free(histograms);
+        PyMem_Free(scratch);
+        return 0;
+}
+
+#undef NUM_PASSES
 
 #ifdef BLIST_FLOAT_RADIX_SORT
 #if SIZEOF_LONG == 8
@@ -5441,6 +7117,9 @@ sort_uint64(sortwrapperobject *restrict sortarray, Py_ssize_t n)
         Py_ssize_t i, j, sums[NUM_PASSES], count[NUM_PASSES], tsum;
         histogram_array_t *histograms;
 
+        if (n >= parallel_sort_threshold)
+                return sort_parallel(sortarray, n, NUM_PASSES, 1);
+
         memset(sums, 0, sizeof sums);
         memset(count, 0, sizeof count);
 
@@ -5502,1525 +7181,3459 @@ sort_uint64(sortwrapperobject *restrict sortarray, Py_ssize_t n)
 #endif
 #endif
 
-BLIST_LOCAL(Py_ssize_t)
-sort(PyBListRoot *restrict self, PyObject *compare, PyObject *keyfunc)
+#ifdef BLIST_WIDE_RADIX_SORT
+#define WIDE_PASSES 8
+
+/* The key of a wrapper, or the field'th item of its tuple key */
+#define WRAPPER_KEY(w, field) \
+        ((field) < 0 ? (w).key : PyTuple_GET_ITEM((w).key, (field)))
+
+/* Stable LSD radix sort of whole wrappers on their k_uint64 */
+BLIST_LOCAL(void)
+radix_sort_wrappers(sortwrapperobject *restrict array, Py_ssize_t n,
+                    sortwrapperobject *restrict scratch,
+                    Py_ssize_t (*histograms)[HISTOGRAM_SIZE])
 {
-        PyBList *leaf;
-        PyBList **leafs;
-        int err=0;
-        Py_ssize_t i, leafs_n = 0;
-        sortwrapperobject sortarraystack[10];
-        sortwrapperobject *sortarray = sortarraystack;
-        int key_flags;
+        sortwrapperobject *from, *to, *tmp;
+        Py_ssize_t i, b, sum, tsum;
+        int j;
 
-        if (self->leaf)
-                leafs = &leaf;
-        else {
-                leafs = PyMem_New(PyBList *, self->n / HALF + 1);
-                if (!leafs)
-                        return -1;
+        memset(histograms, 0,
+               sizeof(Py_ssize_t) * HISTOGRAM_SIZE * WIDE_PASSES);
+        for (i = 0; i < n; i++) {
+                PY_UINT64_T v = array[i].fkey.k_uint64;
+                for (j = 0; j < WIDE_PASSES; j++)
+                        histograms[j][(v >> (BITS_PER_PASS * j)) & MASK]++;
         }
 
-        if (self->leaf) {
-                leaf = (PyBList *) self;
-                leafs_n = 1;
-        } else {
-                linearize_rw(self);
+        from = array;
+        to = scratch;
+        for (j = 0; j < WIDE_PASSES; j++) {
+                Py_ssize_t *restrict histogram = histograms[j];
+                const unsigned shift = BITS_PER_PASS * j;
 
-                assert(INDEX_LENGTH(self) <= self->index_allocated);
-                for (i = 0; i < INDEX_LENGTH(self)-1; i++) {
-                        leaf = self->index_list[i];
-                        if (leaf == self->index_list[i+1])
-                                continue;
-                        leafs[leafs_n++] = leaf;
-                        Py_INCREF(leaf);
+                sum = 0;
+                for (b = 0; b < HISTOGRAM_SIZE; b++) {
+                        if (histogram[b] == n)
+                                break;
+                        tsum = histogram[b] + sum;
+                        histogram[b] = sum;
+                        sum = tsum;
                 }
-                leaf = self->index_list[i];
-                leafs[leafs_n++] = leaf;
-                Py_INCREF(leaf);
-        }
+                if (b < HISTOGRAM_SIZE)
+                        continue; /* Every key has this digit */
 
-        if (self->n > 10) {
-                sortarray = PyMem_New(sortwrapperobject, self->n);
-                if (sortarray == NULL) {
-                        sortarray = sortarraystack;
-                        goto error;
+                for (i = 0; i < n; i++) {
+                        Py_ssize_t pos = histogram[
+                                (from[i].fkey.k_uint64 >> shift) & MASK]++;
+                        to[pos] = from[i];
                 }
-        }
 
-        err = wrap_leaf_array(sortarray, leafs, leafs_n, self->n, keyfunc,
-                              &key_flags);
-        if (err < 0) {
-        error:
-                if (!self->leaf) {
-                        for (i = 0; i < leafs_n; i++)
-                                SAFE_DECREF(leafs[i]);
-                        PyMem_Free(leafs);
-                }
-                if (sortarray != sortarraystack)
-                        PyMem_Free(sortarray);
-                return -1;
+                tmp = from;
+                from = to;
+                to = tmp;
         }
 
-        if (key_flags && compare == NULL) {
-#ifdef BLIST_FLOAT_RADIX_SORT
-                if (key_flags & KEY_ALL_DOUBLE) {
-                        if (self->n < 40 && self->leaf)
-                                err = insertion_sort_uint64(sortarray,self->n);
-                        else
-                                err = sort_uint64(sortarray, self->n);
-                } else
-#endif
-                if (key_flags & KEY_ALL_LONG) {
-                        if (self->n < 40 && self->leaf)
-                                err = insertion_sort_ulong(sortarray, self->n);
-                        else
-                                err = sort_ulong(sortarray, self->n);
-                }
-                else
-                        assert(0); /* Should not be possible */
-                unwrap_leaf_array(leafs, leafs_n, self->n, sortarray);
-                if (!self->leaf) {
-                        for (i = 0; i < leafs_n; i++)
-                                SAFE_DECREF(leafs[i]);
-                        PyMem_Free(leafs);
-                }
-        } else if (self->leaf) {
-                err = gallop_sort(self->children, self->num_children, compare);
-                unwrap_leaf_array(leafs, 1, self->n, sortarray);
-        } else {
-                PyBList **scratch = PyMem_New(PyBList *, self->n / HALF + 1);
-                if (!scratch) {
-                        PyMem_Free(leafs);
-                        PyMem_Free(sortarray);
-                        return -1;
-                }
-                leafs_n = sub_sort(scratch, leafs, compare, leafs_n, &err, 0);
-                array_enable_GC(leafs, leafs_n);
+        if (from != array)
+                memcpy(array, from, n * sizeof(sortwrapperobject));
+}
+
+/* Ints of up to 128 bits are sorted in two stable passes, first on the
+ * low words of their two's complement and then on the high words.
+ * Returns -1 and sets an exception on error. */
+BLIST_LOCAL(int)
+sort_wide_longs(sortwrapperobject *restrict sortarray, Py_ssize_t n,
+                int field)
+{
+        sortwrapperobject *scratch;
+        Py_ssize_t (*histograms)[HISTOGRAM_SIZE];
+        Py_ssize_t i;
+        int pass;
+
+        scratch = PyMem_New(sortwrapperobject, n);
+        histograms = (Py_ssize_t (*)[HISTOGRAM_SIZE])
+                PyMem_Malloc(sizeof(Py_ssize_t) * HISTOGRAM_SIZE
+                             * WIDE_PASSES);
+        if (scratch == NULL || histograms == NULL) {
                 PyMem_Free(scratch);
-                unwrap_leaf_array(leafs, leafs_n, self->n, sortarray);
-                i = blist_init_from_child_array(leafs, leafs_n);
+                PyMem_Free(histograms);
+                PyErr_NoMemory();
+                return -1;
+        }
 
-                if (i < 0) {
-                        /* XXX leaking memory here when out of memory */
-                        PyMem_Free(sortarray);
-                        return -1;
-                } else {
-                        assert(i == 1);
-                        blist_become_and_consume((PyBList *) self, leafs[0]);
+        for (pass = 0; pass < 2; pass++) {
+                for (i = 0; i < n; i++) {
+                        /* Every key was checked to fit, so the
+                         * split never reports a key too wide */
+                        PY_INT64_T hi = 0;
+                        PY_UINT64_T lo = 0;
+                        if (wide_long_split(WRAPPER_KEY(sortarray[i], field),
+                                            &hi, &lo) < 0) {
+                                PyMem_Free(histograms);
+                                PyMem_Free(scratch);
+                                return -1;
+                        }
+                        sortarray[i].fkey.k_uint64 = pass
+                                ? (PY_UINT64_T) hi ^ (1ull << 63ull) : lo;
                 }
-                SAFE_DECREF(leafs[0]);
-                PyMem_Free(leafs);
+                radix_sort_wrappers(sortarray, n, scratch, histograms);
         }
 
-        if (sortarray != sortarraystack)
-                PyMem_Free(sortarray);
-        return err;
+        PyMem_Free(histograms);
+        PyMem_Free(scratch);
+        return 0;
 }
 
-/************************************************************************
- * Section for functions callable directly by the interpreter.
- *
- * Each of these functions are marked with VALID_USER for debug mode.
- *
- * If they, or any function they call, makes calls to decref_later,
- * they must call decref_flush() just before returning.
- *
- * These functions must not be called directly by other blist
- * functions.  They should *only* be called by the interpreter, to
- * ensure that decref_flush() is the last thing called before
- * returning to the interpreter.
+/* Strings are sorted most-significant digit first, where each digit is
+ * a 64-bit chunk packing the next few characters.  Each pass sorts a run
+ * of strings that agree up to some offset by their next chunk, and then
+ * splits it into runs of strings that also agree on that chunk.  Within
+ * such a run, strings ending in the chunk go first, shortest first, and
+ * the rest are sorted on their next chunk in turn.  Small runs are
+ * finished off by insertion sort.  Wrappers move with their keys, and
+ * every step is stable.
  */
 
-BLIST_PYAPI(PyObject *)
-py_blist_root_tp_new(PyTypeObject *subtype, PyObject *args, PyObject *kwds)
-{
-        PyBList *self;
-
-        if (subtype == &PyRootBList_Type)
-                return (PyObject *) blist_root_new();
-
-        self = (PyBList *) subtype->tp_alloc(subtype, 0);
-        if (self == NULL)
-                return NULL;
-        self->children = PyMem_New(PyObject *, LIMIT);
-        if (self->children == NULL) {
-                subtype->tp_free(self);
-                return NULL;
-        }
-
-        self->leaf = 1;
-        ext_init((PyBListRoot *)self);
+#define STRING_RUN_SMALL 16
 
-        return (PyObject *) self;
-}
+typedef struct string_run {
+        Py_ssize_t start, n, offset;
+} string_run_t;
 
-/* Should only be used by the unpickler */
-BLIST_PYAPI(PyObject *)
-py_blist_internal_tp_new(PyTypeObject *subtype, PyObject *args, PyObject *kwds)
+BLIST_LOCAL_INLINE(Py_ssize_t)
+string_length(PyObject *s, int unicode)
 {
-        assert (subtype == &PyBList_Type);
-        return (PyObject *) blist_new();
-}
+#if PY_VERSION_HEX >= 0x03030000
+        if (unicode)
+                return PyUnicode_GET_LENGTH(s);
+#endif
+        return PyBytes_GET_SIZE(s);
+}
+
+/* Pack width characters of s, starting at offset, into a chunk with
+ * bits bits per character.  Missing characters count as zero. */
+BLIST_LOCAL_INLINE(PY_UINT64_T)
+string_chunk(PyObject *s, int unicode, Py_ssize_t offset, int width, int bits)
+{
+        PY_UINT64_T chunk = 0;
+        Py_ssize_t i, stop = offset + width;
+        Py_ssize_t len = string_length(s, unicode);
+
+        if (stop > len)
+                stop = len;
+#if PY_VERSION_HEX >= 0x03030000
+        if (unicode) {
+                int kind = PyUnicode_KIND(s);
+                void *data = PyUnicode_DATA(s);
+                for (i = offset; i < stop; i++)
+                        chunk = (chunk << bits)
+                                | PyUnicode_READ(kind, data, i);
+        } else
+#endif
+        {
+                const unsigned char *data
+                        = (const unsigned char *) PyBytes_AS_STRING(s);
+                for (i = offset; i < stop; i++)
+                        chunk = (chunk << 8) | data[i];
+        }
+        for (i = stop > offset ? stop : offset; i < offset + width; i++)
+                chunk <<= bits;
 
-/* Should only be used by the unpickler */
-BLIST_PYAPI(int)
-py_blist_internal_init(PyObject *oself, PyObject *args, PyObject *kw)
-{
-        return 0;
+        return chunk;
 }
 
-BLIST_PYAPI(int)
-py_blist_init(PyObject *oself, PyObject *args, PyObject *kw)
+/* Returns true if a < b, given that they agree before offset */
+BLIST_LOCAL_INLINE(int)
+string_lt(PyObject *a, PyObject *b, int unicode, Py_ssize_t offset)
 {
-        int ret;
-        PyObject *arg = NULL;
-        static char *kwlist[] = {"sequence", 0};
-        int err;
-        PyBList *self;
-
-        invariants(oself, VALID_USER|VALID_DECREF);
-        self = (PyBList *) oself;
+        Py_ssize_t len_a, len_b, len;
 
-        DANGER_BEGIN;
-        err = PyArg_ParseTupleAndKeywords(args, kw, "|O:list", kwlist, &arg);
-        DANGER_END;
-        if (!err)
-                return _int(-1);
+        len_a = string_length(a, unicode);
+        len_b = string_length(b, unicode);
+        len = len_a < len_b ? len_a : len_b;
 
-        if (self->n) {
-                blist_CLEAR(self);
-                ext_dealloc((PyBListRoot *) self);
+#if PY_VERSION_HEX >= 0x03030000
+        if (unicode) {
+                int kind_a = PyUnicode_KIND(a), kind_b = PyUnicode_KIND(b);
+                void *data_a = PyUnicode_DATA(a);
+                void *data_b = PyUnicode_DATA(b);
+                Py_ssize_t i;
+                for (i = offset; i < len; i++) {
+                        Py_UCS4 ca = PyUnicode_READ(kind_a, data_a, i);
+                        Py_UCS4 cb = PyUnicode_READ(kind_b, data_b, i);
+                        if (ca != cb)
+                                return ca < cb;
+                }
+        } else
+#endif
+        if (len > offset) {
+                int c = memcmp(PyBytes_AS_STRING(a) + offset,
+                               PyBytes_AS_STRING(b) + offset, len - offset);
+                if (c)
+                        return c < 0;
         }
 
-        if (arg == NULL)
-                return _int(0);
-
-        ret = blist_init_from_seq(self, arg);
-
-        decref_flush(); /* Needed due to blist_CLEAR() call */
-        return _int(ret);
+        return len_a < len_b;
 }
 
-BLIST_PYAPI(PyObject *)
-py_blist_richcompare(PyObject *v, PyObject *w, int op)
+BLIST_LOCAL(void)
+insertion_sort_string(sortwrapperobject *array, Py_ssize_t n, int unicode,
+                      int field, Py_ssize_t offset)
 {
-        PyObject *rv;
-
-        if (!PyRootBList_Check(v)) {
-        not_implemented:
-                Py_INCREF(Py_NotImplemented);
-                return Py_NotImplemented;
-        }
+        Py_ssize_t i, j;
+        sortwrapperobject tmp;
 
-        invariants((PyBList *) v, VALID_USER|VALID_DECREF);
-        if (PyRootBList_Check(w)) {
-                rv = blist_richcompare_blist((PyBList *)v, (PyBList *)w, op);
-                decref_flush();
-                return _ob(rv);
-        }
-#ifndef Py_BUILD_CORE
-        if (PyList_Check(w)) {
-                rv = blist_richcompare_list((PyBList*)v, (PyListObject*)w, op);
-                decref_flush();
-                return _ob(rv);
+        for (i = 1; i < n; i++) {
+                tmp = array[i];
+                for (j = i; j >= 1; j--) {
+                        if (!string_lt(WRAPPER_KEY(tmp, field),
+                                       WRAPPER_KEY(array[j-1], field),
+                                       unicode, offset))
+                                break;
+                        array[j] = array[j-1];
+                }
+                array[j] = tmp;
         }
-#endif
-        _void();
-        goto not_implemented;
 }
 
-BLIST_PYAPI(int)
-py_blist_traverse(PyObject *oself, visitproc visit, void *arg)
+/* Sort an array of bytes (or, if unicode, str) keys, or of tuple keys
+ * by their field'th item.  Returns -1 and sets an exception if out of
+ * memory. */
+BLIST_LOCAL(int)
+sort_strings(sortwrapperobject *restrict sortarray, Py_ssize_t n,
+             int unicode, int field)
 {
-        PyBList *self;
-        int i;
+        sortwrapperobject *scratch;
+        Py_ssize_t (*histograms)[HISTOGRAM_SIZE];
+        string_run_t *stack;
+        Py_ssize_t i, j, k, top = 0;
+        int width = 8, bits = 8;
 
-        assert(PyBList_Check(oself));
-        self = (PyBList *) oself;
+        if (n <= STRING_RUN_SMALL) {
+                insertion_sort_string(sortarray, n, unicode, field, 0);
+                return 0;
+        }
 
-        for (i = 0; i < self->num_children; i++) {
-                if (self->children[i] != NULL)
-                        Py_VISIT(self->children[i]);
+#if PY_VERSION_HEX >= 0x03030000
+        if (unicode) {
+                int kind = PyUnicode_1BYTE_KIND;
+                for (i = 0; i < n; i++) {
+                        PyObject *key = WRAPPER_KEY(sortarray[i], field);
+                        if (PyUnicode_KIND(key) > kind)
+                                kind = PyUnicode_KIND(key);
+                }
+                if (kind == PyUnicode_2BYTE_KIND) {
+                        width = 4;
+                        bits = 16;
+                } else if (kind == PyUnicode_4BYTE_KIND) {
+                        width = 3;
+                        bits = 21;
+                }
         }
-        return 0;
-}
+#endif
 
-BLIST_PYAPI(int)
-py_blist_tp_clear(PyObject *oself)
-{
-        PyBList *self;
+        /* Runs on the stack are disjoint and hold at least two wrappers */
+        scratch = PyMem_New(sortwrapperobject, n);
+        histograms = (Py_ssize_t (*)[HISTOGRAM_SIZE])
+                PyMem_Malloc(sizeof(Py_ssize_t) * HISTOGRAM_SIZE
+                             * WIDE_PASSES);
+        stack = PyMem_New(string_run_t, n/2 + 1);
+        if (scratch == NULL || histograms == NULL || stack == NULL) {
+                PyMem_Free(scratch);
+                PyMem_Free(histograms);
+                PyMem_Free(stack);
+                PyErr_NoMemory();
+                return -1;
+        }
 
-        invariants(oself, VALID_USER|VALID_RW|VALID_DECREF);
-        self = (PyBList *) oself;
+        stack[top].start = 0;
+        stack[top].n = n;
+        stack[top].offset = 0;
+        top++;
 
-        blist_forget_children(self);
-        self->n = 0;
-        self->leaf = 1;
-        ext_dealloc((PyBListRoot *) self);
+        while (top) {
+                string_run_t run = stack[--top];
+                sortwrapperobject *restrict array = &sortarray[run.start];
+                Py_ssize_t next = run.offset + width;
 
-        decref_flush();
-        return _int(0);
-}
+                if (run.n <= STRING_RUN_SMALL) {
+                        insertion_sort_string(array, run.n, unicode, field,
+                                              run.offset);
+                        continue;
+                }
 
-#if PY_MAJOR_VERSION == 2 && PY_MINOR_VERSION >= 6 || PY_MAJOR_VERSION >= 3
-#define py_blist_nohash PyObject_HashNotImplemented
-#else
-BLIST_PYAPI(long)
-py_blist_nohash(PyObject *self)
-{
-        PyErr_SetString(PyExc_TypeError, "list objects are unhashable");
-        return -1;
-}
-#endif
+                for (i = 0; i < run.n; i++)
+                        array[i].fkey.k_uint64 = string_chunk(
+                                WRAPPER_KEY(array[i], field), unicode,
+                                run.offset, width, bits);
+                radix_sort_wrappers(array, run.n, scratch, histograms);
 
-BLIST_PYAPI(void)
-py_blist_dealloc(PyObject *oself)
-{
-        int i;
-        PyBList *self;
+                for (i = 0; i < run.n; i = j) {
+                        Py_ssize_t ended = 0;
+                        PY_UINT64_T chunk = array[i].fkey.k_uint64;
 
-        assert(PyBList_Check(oself));
-        self = (PyBList *) oself;
+                        for (j = i+1; j < run.n; j++)
+                                if (array[j].fkey.k_uint64 != chunk)
+                                        break;
+                        if (j - i < 2)
+                                continue;
 
-        if (_PyObject_GC_IS_TRACKED(self))
-                PyObject_GC_UnTrack(self);
+                        for (k = i; k < j; k++) {
+                                Py_ssize_t len = string_length(
+                                        WRAPPER_KEY(array[k], field),
+                                        unicode);
+                                if (len <= next) {
+                                        ended++;
+                                        array[k].fkey.k_uint64 = len;
+                                } else
+                                        array[k].fkey.k_uint64
+                                                = ~(PY_UINT64_T) 0;
+                        }
 
-        Py_TRASHCAN_SAFE_BEGIN(self)
+                        /* A string ending in this chunk is a prefix of
+                         * every longer string in the run */
+                        if (ended)
+                                radix_sort_wrappers(&array[i], j - i,
+                                                    scratch, histograms);
+
+                        if (j - i - ended >= 2) {
+                                stack[top].start = run.start + i + ended;
+                                stack[top].n = j - i - ended;
+                                stack[top].offset = next;
+                                top++;
+                        }
+                }
+        }
 
-        /* Py_XDECREF() is needed here because the Python C API allows list
-         * items to be NULL. */
-        for (i = 0; i < self->num_children; i++)
-                Py_XDECREF(self->children[i]);
+        PyMem_Free(stack);
+        PyMem_Free(histograms);
+        PyMem_Free(scratch);
+        return 0;
+}
 
-        if (PyRootBList_Check(self)) {
-                ext_dealloc((PyBListRoot *) self);
-                if (PyRootBList_CheckExact(self)
-                    && num_free_ulists < MAXFREELISTS)
-                        free_ulists[num_free_ulists++] = self;
-                else
-                        goto free_blist;
-        } else if (Py_TYPE(self) == &PyBList_Type
-                   && num_free_lists < MAXFREELISTS)
-                free_lists[num_free_lists++] = self;
-        else {
-        free_blist:
-                PyMem_Free(self->children);
-                Py_TYPE(self)->tp_free((PyObject *)self);
+/* Returns the radix key of a field that field_flags() found in every
+ * tuple key, given the flags it left.  Sets *ok to 0 if some int field
+ * has no exact double. */
+BLIST_LOCAL_INLINE(PY_UINT64_T)
+field_key(PyObject *v, int flags, int *ok)
+{
+#ifdef BLIST_FLOAT_RADIX_SORT
+        if (!(flags & KEY_ALL_LONG)) {
+                double d;
+                if (Py_TYPE(v) == &PyFloat_Type)
+                        d = PyFloat_AS_DOUBLE(v);
+                else if (!long_as_exact_double(v, &d)) {
+                        *ok = 0;
+                        return 0;
+                }
+                return double_key(d);
         }
-
-        Py_TRASHCAN_SAFE_END(self);
+#endif
+        return (PY_UINT64_T) PyLong_AsLongLong(v) ^ (1ull << 63ull);
 }
 
-BLIST_PYAPI(int)
-py_blist_ass_item(PyObject *oself, Py_ssize_t i, PyObject *v)
+/* Tuple keys of the same length, whose fields are all ints, floats,
+ * bytes or str, sort in one stable pass per field from last to first.
+ * Returns 1 if sorted, 0 if the keys don't qualify, or -1 on error. */
+static int
+sort_tuples(sortwrapperobject *restrict sortarray, Py_ssize_t n)
 {
-        PyObject *old_value;
-        PyBList *self;
+        sortwrapperobject *scratch = NULL;
+        Py_ssize_t (*histograms)[HISTOGRAM_SIZE] = NULL;
+        Py_ssize_t i, m;
+        int *flags, j, ok = 1, err = 0;
 
-        invariants(oself, VALID_USER|VALID_RW|VALID_DECREF);
+        if (n == 0)
+                return 1;
+        m = PyTuple_GET_SIZE(sortarray[0].key);
+        for (i = 1; i < n; i++)
+                if (PyTuple_GET_SIZE(sortarray[i].key) != m)
+                        return 0;
+        if (m == 0)
+                return 1;
 
-        self = (PyBList *) oself;
+        flags = PyMem_New(int, m);
+        if (flags == NULL) {
+                PyErr_NoMemory();
+                return -1;
+        }
+        for (j = 0; j < m && ok; j++) {
+                flags[j] = -1;
+                for (i = 0; i < n && flags[j]; i++)
+                        flags[j] &= field_flags(
+                                PyTuple_GET_ITEM(sortarray[i].key, j));
+                if (!flags[j])
+                        ok = 0;
+                else if (flags[j] == KEY_ALL_NUMBER) {
+#ifdef BLIST_FLOAT_RADIX_SORT
+                        for (i = 0; i < n && ok; i++)
+                                field_key(PyTuple_GET_ITEM(sortarray[i].key,
+                                                           j),
+                                          KEY_ALL_NUMBER, &ok);
+#else
+                        ok = 0;
+#endif
+                }
+        }
+        if (!ok) {
+                PyMem_Free(flags);
+                return 0;
+        }
 
-        if (i >= self->n || i < 0) {
-                set_index_error();
-                return _int(-1);
+        scratch = PyMem_New(sortwrapperobject, n);
+        histograms = (Py_ssize_t (*)[HISTOGRAM_SIZE])
+                PyMem_Malloc(sizeof(Py_ssize_t) * HISTOGRAM_SIZE
+                             * WIDE_PASSES);
+        if (scratch == NULL || histograms == NULL) {
+                PyErr_NoMemory();
+                err = -1;
+                goto done;
         }
 
-        if (v == NULL) {
-                blist_delitem(self, i);
-                ext_mark(self, 0, DIRTY);
-                decref_flush();
-                return _int(0);
+        for (j = m-1; j >= 0 && err >= 0; j--) {
+                if (flags[j] & (KEY_ALL_BYTES | KEY_ALL_STR))
+                        err = sort_strings(sortarray, n,
+                                           flags[j] & KEY_ALL_STR, j);
+                else if ((flags[j] & (KEY_ALL_LONG | KEY_ALL_WIDE))
+                         == KEY_ALL_WIDE)
+                        err = sort_wide_longs(sortarray, n, j);
+                else {
+                        for (i = 0; i < n; i++)
+                                sortarray[i].fkey.k_uint64 = field_key(
+                                        PyTuple_GET_ITEM(sortarray[i].key, j),
+                                        flags[j], &ok);
+                        radix_sort_wrappers(sortarray, n, scratch,
+                                            histograms);
+                }
         }
 
-        old_value = blist_ass_item_return(self, i, v);
-        Py_XDECREF(old_value);
-        return _int(0);
+ done:
+        PyMem_Free(histograms);
+        PyMem_Free(scratch);
+        PyMem_Free(flags);
+        return err < 0 ? -1 : 1;
 }
 
-BLIST_PYAPI(int)
-py_blist_ass_slice(PyObject *oself, Py_ssize_t ilow, Py_ssize_t ihigh,
-                   PyObject *v)
+#undef WIDE_PASSES
+#endif
+
+/* Sorts self.  If keysrc is not NULL, item i of self sorts as if it
+ * were keysrc[i].
+ *
+ * A plain sort of keys that are all ints, floats, or strings notes in
+ * self->sorted_n that the whole list is sorted.  These types cannot
+ * change their order behind our back, so later sorts may rely on it.
+ */
+BLIST_LOCAL(Py_ssize_t)
+sort(PyBListRoot *restrict self, PyObject *compare, PyObject *keyfunc,
+     PyObject **keysrc)
 {
-        Py_ssize_t net;
-        PyBList *other, *left, *right, *self;
+        PyBList *leaf;
+        PyBList **leafs;
+        int err=0;
+        Py_ssize_t i, leafs_n = 0;
+        sortwrapperobject sortarraystack[10];
+        sortwrapperobject *sortarray = sortarraystack;
+        int key_flags = 0;
+        keyfunc_t kf;
 
-        invariants(oself, VALID_RW|VALID_USER|VALID_DECREF);
+        self->sorted_n = 0;
 
-        self = (PyBList *) oself;
+        if (self->leaf)
+                leafs = &leaf;
+        else {
+                leafs = PyMem_New(PyBList *, self->n / HALF + 1);
+                if (!leafs)
+                        return -1;
+        }
 
-        if (ilow < 0) ilow = 0;
-        else if (ilow > self->n) ilow = self->n;
-        if (ihigh < ilow) ihigh = ilow;
-        else if (ihigh > self->n) ihigh = self->n;
+        if (self->leaf) {
+                leaf = (PyBList *) self;
+                leafs_n = 1;
+        } else {
+                linearize_rw(self);
 
-        if (!v) {
-                blist_delslice(self, ilow, ihigh);
-                ext_mark(self, 0, DIRTY);
-                decref_flush();
-                return _int(0);
+                assert(INDEX_LENGTH(self) <= self->index_allocated);
+                for (i = 0; i < INDEX_LENGTH(self)-1; i++) {
+                        leaf = self->index_list[i];
+                        if (leaf == self->index_list[i+1])
+                                continue;
+                        leafs[leafs_n++] = leaf;
+                        Py_INCREF(leaf);
+                }
+                leaf = self->index_list[i];
+                leafs[leafs_n++] = leaf;
+                Py_INCREF(leaf);
         }
 
-        if (PyRootBList_Check(v) && (PyObject *) self != v) {
-                other = (PyBList *) v;
-                Py_INCREF(other);
-                ext_mark_set_dirty_all(other);
+        if (self->n > 10) {
+                sortarray = PyMem_New(sortwrapperobject, self->n);
+                if (sortarray == NULL) {
+                        sortarray = sortarraystack;
+                        goto error;
+                }
+        }
+
+        keyfunc_init(&kf, keyfunc);
+        err = wrap_leaf_array(sortarray, leafs, leafs_n, self->n,
+                              keyfunc ? &kf : NULL, keysrc, &key_flags);
+        keyfunc_release(&kf);
+        if (err < 0) {
+        error:
+                if (!self->leaf) {
+                        for (i = 0; i < leafs_n; i++)
+                                SAFE_DECREF(leafs[i]);
+                        PyMem_Free(leafs);
+                }
+                if (sortarray != sortarraystack)
+                        PyMem_Free(sortarray);
+                return -1;
+        }
+
+#ifdef BLIST_FLOAT_RADIX_SORT
+        /* A mix of ints and floats sorts as floats, if it can */
+        if (key_flags == KEY_ALL_NUMBER)
+                key_flags = encode_numbers(sortarray, self->n)
+                        ? KEY_ALL_DOUBLE : 0;
+#else
+        key_flags &= ~KEY_ALL_NUMBER;
+#endif
+#ifdef BLIST_WIDE_RADIX_SORT
+        /* Tuples sort field by field, if every field can */
+        if (key_flags == KEY_ALL_TUPLE && compare == NULL) {
+                int sorted = sort_tuples(sortarray, self->n);
+                if (sorted < 0)
+                        err = -1;
+                else if (!sorted)
+                        key_flags = 0;
+        }
+#else
+        key_flags &= ~(KEY_ALL_WIDE | KEY_ALL_TUPLE);
+#endif
+
+        if (key_flags && compare == NULL) {
+#ifdef BLIST_WIDE_RADIX_SORT
+                if (key_flags == KEY_ALL_TUPLE)
+                        ; /* Sorted above */
+                else if (key_flags & (KEY_ALL_BYTES | KEY_ALL_STR))
+                        err = sort_strings(sortarray, self->n,
+                                           key_flags & KEY_ALL_STR, -1);
+                else if ((key_flags & (KEY_ALL_LONG | KEY_ALL_WIDE))
+                         == KEY_ALL_WIDE)
+                        err = sort_wide_longs(sortarray, self->n, -1);
+                else
+#endif
+#ifdef BLIST_FLOAT_RADIX_SORT
+                if (key_flags & KEY_ALL_DOUBLE) {
+                        if (self->n < 40 && self->leaf)
+                                err = insertion_sort_uint64(sortarray,self->n);
+                        else
+                                err = sort_uint64(sortarray, self->n);
+                } else
+#endif
+                if (key_flags & KEY_ALL_LONG) {
+                        if (self->n < 40 && self->leaf)
+                                err = insertion_sort_ulong(sortarray, self->n);
+                        else
+                                err = sort_ulong(sortarray, self->n);
+                }
+                else
+                        assert(0); /* Should not be possible */
+                unwrap_leaf_array(leafs, leafs_n, self->n, sortarray);
+                if (!self->leaf) {
+                        for (i = 0; i < leafs_n; i++)
+                                SAFE_DECREF(leafs[i]);
+                        PyMem_Free(leafs);
+                }
+        } else if (self->leaf) {
+                err = gallop_sort(self->children, self->num_children, compare);
+                unwrap_leaf_array(leafs, 1, self->n, sortarray);
         } else {
-                other = blist_root_new();
-                if (v) {
-                        int err = blist_init_from_seq(other, v);
-                        if (err < 0) {
-                                decref_later((PyObject *) other);
-                                decref_flush();
-                                return _int(-1);
-                        }
+                PyBList **scratch = PyMem_New(PyBList *, self->n / HALF + 1);
+                if (!scratch) {
+                        PyMem_Free(leafs);
+                        PyMem_Free(sortarray);
+                        return -1;
                 }
+                leafs_n = sub_sort(scratch, leafs, compare, leafs_n, &err, 0);
+                array_enable_GC(leafs, leafs_n);
+                PyMem_Free(scratch);
+                unwrap_leaf_array(leafs, leafs_n, self->n, sortarray);
+                i = blist_init_from_child_array(leafs, leafs_n);
+
+                if (i < 0) {
+                        /* XXX leaking memory here when out of memory */
+                        PyMem_Free(sortarray);
+                        return -1;
+                } else {
+                        assert(i == 1);
+                        blist_become_and_consume((PyBList *) self, leafs[0]);
+                }
+                SAFE_DECREF(leafs[0]);
+                PyMem_Free(leafs);
         }
 
-        net = other->n - (ihigh - ilow);
+        if (sortarray != sortarraystack)
+                PyMem_Free(sortarray);
+#ifndef BLIST_IN_PYTHON
+        /* (Inside the interpreter, PyList_SET_ITEM bypasses
+         * sorted_prefix_cut, so we cannot keep track.) */
+        if (err >= 0 && compare == NULL && keyfunc == NULL && keysrc == NULL
+            && key_flags && key_flags != KEY_ALL_TUPLE)
+                self->sorted_n = self->n;
+#endif
+        return err;
+}
 
-        /* Special case small lists */
-        if (self->leaf && other->leaf && (self->n + net <= LIMIT))
-        {
-                Py_ssize_t i;
+/* Locate the rightmost insertion point for item in a sorted root, as
+ * blist_bisect(self, item, 0, 1) does.  Returns -1 on error.
+ *
+ * Only for the private lists of sort_tail(), which no comparison can
+ * modify, so we need not hold references while we descend.
+ */
+BLIST_LOCAL(Py_ssize_t)
+bisect_sorted_prefix(PyBList *p, PyObject *item)
+{
+        Py_ssize_t offset = 0;
+        int lo, hi, mid, c, k;
+        fast_compare_data_t fast_cmp_type;
 
-                for (i = ilow; i < ihigh; i++)
-                        decref_later(self->children[i]);
+        fast_cmp_type = check_fast_cmp_type(item, Py_LT);
 
-                if (net >= 0)
-                        shift_right(self, ihigh, net);
+        while (!p->leaf) {
+                PyBList *child;
+
+                lo = 1;
+                hi = p->num_children;
+                while (lo < hi) {
+                        mid = (lo + hi) / 2;
+                        for (child = (PyBList *) p->children[mid];
+                             !child->leaf;
+                             child = (PyBList *) child->children[0])
+                                ;
+                        c = fast_lt(item, child->children[0], fast_cmp_type);
+                        if (c < 0)
+                                return -1;
+                        if (c)
+                                hi = mid;
+                        else
+                                lo = mid + 1;
+                }
+                for (k = 0; k < lo - 1; k++)
+                        offset += ((PyBList *) p->children[k])->n;
+                p = (PyBList *) p->children[lo - 1];
+        }
+
+        lo = 0;
+        hi = p->num_children;
+        while (lo < hi) {
+                mid = (lo + hi) / 2;
+                c = fast_lt(item, p->children[mid], fast_cmp_type);
+                if (c < 0)
+                        return -1;
+                if (c)
+                        hi = mid;
                 else
-                        shift_left(self, ihigh, -net);
-                self->num_children += net;
-                copyref(self, ilow, other, 0, other->n);
-                SAFE_DECREF(other);
-                blist_adjust_n(self);
-                decref_flush();
+                        lo = mid + 1;
+        }
+
+        return offset + lo;
+}
+
+/* Sorts self, whose first self->sorted_n items are in order, as they
+ * are after appending to a sorted list.  We sort the remaining m items
+ * on their own, then insert each after any equal items before it.  This
+ * takes O(m log n) operations, rather than O(n log n) to sort the whole
+ * list again.
+ */
+BLIST_LOCAL(Py_ssize_t)
+sort_tail(PyBListRoot *restrict self)
+{
+        PyBList *tail;
+        PyObject *item;
+        Py_ssize_t i, m, k = self->sorted_n;
+        Py_ssize_t err;
+        int sorted;
+
+        m = self->n - k;
+        if (m == 0)
+                return 0;
+
+        tail = blist_root_copy((PyBList *) self);
+        if (tail == NULL)
+                return -1;
+        blist_delslice(tail, 0, k);
+        ext_mark(tail, 0, DIRTY);
+        blist_delslice((PyBList *) self, k, self->n);
+        ext_mark((PyBList *) self, 0, DIRTY);
+
+        err = sort((PyBListRoot *) tail, NULL, NULL, NULL);
+        sorted = ((PyBListRoot *) tail)->sorted_n == m;
+
+        /* After an error, put the remaining items back at the end */
+        ITER(tail, item, {
+                i = self->n;
+                if (err >= 0) {
+                        i = bisect_sorted_prefix((PyBList *) self, item);
+                        if (i < 0) {
+                                err = -1;
+                                i = self->n;
+                        }
+                }
+                blist_insert_root((PyBList *) self, i, item);
+        });
+        decref_later((PyObject *) tail);
+
+        self->sorted_n = (err >= 0 && sorted) ? self->n : 0;
+        return err;
+}
+
+/************************************************************************
+ * Section for functions callable directly by the interpreter.
+ *
+ * Each of these functions are marked with VALID_USER for debug mode.
+ *
+ * If they, or any function they call, makes calls to decref_later,
+ * they must call decref_flush() just before returning.
+ *
+ * These functions must not be called directly by other blist
+ * functions.  They should *only* be called by the interpreter, to
+ * ensure that decref_flush() is the last thing called before
+ * returning to the interpreter.
+ */
+
+BLIST_PYAPI(PyObject *)
+py_blist_root_tp_new(PyTypeObject *subtype, PyObject *args, PyObject *kwds)
+{
+        PyBList *self;
+
+        if (subtype == &PyRootBList_Type)
+                return (PyObject *) blist_root_new();
+
+        /* tp_alloc zeroes the object, leaving an empty children array */
+        self = (PyBList *) subtype->tp_alloc(subtype, 0);
+        if (self == NULL)
+                return NULL;
+
+        self->leaf = 1;
+        ext_init((PyBListRoot *)self);
+        ext_policy_init((PyBListRoot *)self);
+
+        return (PyObject *) self;
+}
+
+/* Should only be used by the unpickler */
+BLIST_PYAPI(PyObject *)
+py_blist_internal_tp_new(PyTypeObject *subtype, PyObject *args, PyObject *kwds)
+{
+        assert (subtype == &PyBList_Type);
+        return (PyObject *) blist_new();
+}
+
+/* Should only be used by the unpickler */
+BLIST_PYAPI(int)
+py_blist_internal_init(PyObject *oself, PyObject *args, PyObject *kw)
+{
+        return 0;
+}
+
+BLIST_PYAPI(int)
+py_blist_init(PyObject *oself, PyObject *args, PyObject *kw)
+{
+        int ret;
+        PyObject *arg = NULL;
+        static char *kwlist[] = {"sequence", 0};
+        int err;
+        PyBList *self;
+
+        invariants(oself, VALID_USER|VALID_DECREF);
+        self = (PyBList *) oself;
+
+        DANGER_BEGIN;
+        err = PyArg_ParseTupleAndKeywords(args, kw, "|O:list", kwlist, &arg);
+        DANGER_END;
+        if (!err)
+                return _int(-1);
+
+        if (self->n) {
+                blist_CLEAR(self);
+                ext_dealloc((PyBListRoot *) self);
+                sorted_prefix_cut(self, 0);
+        }
+
+        if (arg == NULL)
                 return _int(0);
+
+        ret = blist_init_from_seq(self, arg);
+
+        decref_flush(); /* Needed due to blist_CLEAR() call */
+        return _int(ret);
+}
+
+BLIST_PYAPI(PyObject *)
+py_blist_richcompare(PyObject *v, PyObject *w, int op)
+{
+        PyObject *rv;
+
+        if (!PyRootBList_Check(v)) {
+        not_implemented:
+                Py_INCREF(Py_NotImplemented);
+                return Py_NotImplemented;
+        }
+
+        invariants((PyBList *) v, VALID_USER|VALID_DECREF);
+        if (PyRootBList_Check(w)) {
+                rv = blist_richcompare_blist((PyBList *)v, (PyBList *)w, op);
+                decref_flush();
+                return _ob(rv);
+        }
+#ifndef Py_BUILD_CORE
+        if (PyList_Check(w)) {
+                rv = blist_richcompare_list((PyBList*)v, (PyListObject*)w, op);
+                decref_flush();
+                return _ob(rv);
+        }
+#endif
+        _void();
+        goto not_implemented;
+}
+
+BLIST_PYAPI(int)
+py_blist_traverse(PyObject *oself, visitproc visit, void *arg)
+{
+        PyBList *self;
+        int i;
+
+        assert(PyBList_Check(oself));
+        self = (PyBList *) oself;
+
+        for (i = 0; i < self->num_children; i++) {
+                if (self->children[i] != NULL)
+                        Py_VISIT(self->children[i]);
+        }
+        return 0;
+}
+
+BLIST_PYAPI(int)
+py_blist_tp_clear(PyObject *oself)
+{
+        PyBList *self;
+
+        invariants(oself, VALID_USER|VALID_RW|VALID_DECREF);
+        self = (PyBList *) oself;
+
+        blist_forget_children(self);
+        self->n = 0;
+        self->leaf = 1;
+        ext_dealloc((PyBListRoot *) self);
+        sorted_prefix_cut(self, 0);
+
+        decref_flush();
+        return _int(0);
+}
+
+#if PY_MAJOR_VERSION == 2 && PY_MINOR_VERSION >= 6 || PY_MAJOR_VERSION >= 3
+#define py_blist_nohash PyObject_HashNotImplemented
+#else
+BLIST_PYAPI(long)
+py_blist_nohash(PyObject *self)
+{
+        PyErr_SetString(PyExc_TypeError, "list objects are unhashable");
+        return -1;
+}
+#endif
+
+/* Make room for more cached nodes.  Returns -1 if there is no memory */
+static int free_lists_grow(void)
+{
+        PyBList **tmp = free_lists;
+        int n = allocated_free_lists ? allocated_free_lists * 2 : MAXFREELISTS;
+
+        if (n > max_free_lists)
+                n = max_free_lists;
+        PyMem_Resize(tmp, PyBList *, n);
+        if (tmp == NULL)
+                return -1;
+        free_lists = tmp;
+        allocated_free_lists = n;
+        return 0;
+}
+
+BLIST_PYAPI(void)
+py_blist_dealloc(PyObject *oself)
+{
+        int i;
+        PyBList *self;
+
+        assert(PyBList_Check(oself));
+        self = (PyBList *) oself;
+
+        if (_PyObject_GC_IS_TRACKED(self))
+                PyObject_GC_UnTrack(self);
+
+        Py_TRASHCAN_SAFE_BEGIN(self)
+
+        /* Py_XDECREF() is needed here because the Python C API allows list
+         * items to be NULL. */
+        for (i = 0; i < self->num_children; i++)
+                Py_XDECREF(self->children[i]);
+
+        if (PyRootBList_Check(self)) {
+                ext_dealloc((PyBListRoot *) self);
+                if (PyRootBList_CheckExact(self)
+                    && num_free_ulists < MAXFREELISTS)
+                        free_ulists[num_free_ulists++] = self;
+                else
+                        goto free_blist;
+        } else if (Py_TYPE(self) == &PyBList_Type
+                   && num_free_lists < max_free_lists
+                   && (num_free_lists < allocated_free_lists
+                       || free_lists_grow() >= 0))
+                free_lists[num_free_lists++] = self;
+        else {
+        free_blist:
+                if (!HAS_INLINE_CHILDREN(self))
+                        root_children_free((PyBListRoot *) self);
+                PyMem_Free(self->sizes);
+                Py_TYPE(self)->tp_free((PyObject *)self);
+        }
+
+        Py_TRASHCAN_SAFE_END(self);
+}
+
+BLIST_PYAPI(int)
+py_blist_ass_item(PyObject *oself, Py_ssize_t i, PyObject *v)
+{
+        PyObject *old_value;
+        PyBList *self;
+
+        invariants(oself, VALID_USER|VALID_RW|VALID_DECREF);
+
+        self = (PyBList *) oself;
+
+        if (i >= self->n || i < 0) {
+                set_index_error();
+                return _int(-1);
+        }
+
+        sorted_prefix_cut(self, i);
+
+        if (v == NULL) {
+                blist_delitem(self, i);
+                ext_mark_moved(self, i, self->n + 1);
+                decref_flush();
+                return _int(0);
+        }
+
+        old_value = blist_ass_item_return(self, i, v);
+        Py_XDECREF(old_value);
+        return _int(0);
+}
+
+BLIST_PYAPI(int)
+py_blist_ass_slice(PyObject *oself, Py_ssize_t ilow, Py_ssize_t ihigh,
+                   PyObject *v)
+{
+        Py_ssize_t net;
+        PyBList *other, *left, *right, *self;
+
+        invariants(oself, VALID_RW|VALID_USER|VALID_DECREF);
+
+        self = (PyBList *) oself;
+
+        if (ilow < 0) ilow = 0;
+        else if (ilow > self->n) ilow = self->n;
+        if (ihigh < ilow) ihigh = ilow;
+        else if (ihigh > self->n) ihigh = self->n;
+
+        sorted_prefix_cut(self, ilow);
+
+        if (!v) {
+                blist_delslice(self, ilow, ihigh);
+                ext_mark(self, 0, DIRTY);
+                decref_flush();
+                return _int(0);
+        }
+
+        if (PyRootBList_Check(v) && (PyObject *) self != v) {
+                other = (PyBList *) v;
+                Py_INCREF(other);
+                ext_mark_set_dirty_all(other);
+        } else {
+                other = blist_root_new();
+                if (v) {
+                        int err = blist_init_from_seq(other, v);
+                        if (err < 0) {
+                                decref_later((PyObject *) other);
+                                decref_flush();
+                                return _int(-1);
+                        }
+                }
+        }
+
+        net = other->n - (ihigh - ilow);
+
+        if (blist_root_reserve(self, self->leaf && other->leaf
+                               ? self->n + net : LIMIT) < 0) {
+                SAFE_DECREF(other);
+                decref_flush();
+                return _int(-1);
+        }
+
+        /* Special case small lists */
+        if (self->leaf && other->leaf && (self->n + net <= LIMIT))
+        {
+                Py_ssize_t i;
+
+                for (i = ilow; i < ihigh; i++)
+                        decref_later(self->children[i]);
+
+                if (net >= 0)
+                        shift_right(self, ihigh, net);
+                else
+                        shift_left(self, ihigh, -net);
+                self->num_children += net;
+                copyref(self, ilow, other, 0, other->n);
+                SAFE_DECREF(other);
+                blist_adjust_n(self);
+                decref_flush();
+                return _int(0);
+        }
+
+        left = self;
+        right = blist_root_copy(self);
+        if (right == NULL) {
+                SAFE_DECREF(other);
+                decref_flush();
+                return _int(-1);
+        }
+        blist_delslice(left, ilow, left->n);
+        blist_delslice(right, 0, ihigh);
+        blist_extend_blist(left, other); /* XXX check return values */
+        blist_extend_blist(left, right);
+
+        ext_mark(self, 0, DIRTY);
+
+        SAFE_DECREF(other);
+        SAFE_DECREF(right);
+
+        decref_flush();
+
+        return _int(0);
+}
+
+BLIST_PYAPI(int)
+py_blist_ass_subscript(PyObject *oself, PyObject *item, PyObject *value)
+{
+        PyBList *self;
+
+        invariants(oself, VALID_USER|VALID_RW|VALID_DECREF);
+
+        self = (PyBList *) oself;
+
+        if (PyIndex_Check(item)) {
+                Py_ssize_t i;
+                PyObject *old_value;
+
+                if (PyLong_CheckExact(item)) {
+                        i = PyInt_AsSsize_t(item);
+                        if (i == -1 && PyErr_Occurred()) {
+                                PyErr_Clear();
+                                goto number;
+                        }
+                } else {
+                number:
+                        i = PyNumber_AsSsize_t(item, PyExc_IndexError);
+                        if (i == -1 && PyErr_Occurred())
+                                return _int(-1);
+                }
+                if (i < 0)
+                        i += self->n;
+
+                if (i >= self->n || i < 0) {
+                        set_index_error();
+                        return _int(-1);
+                }
+
+                sorted_prefix_cut(self, i);
+
+                if (self->leaf) {
+                        /* Speed up common cases */
+
+                        old_value = self->children[i];
+                        if (value == NULL) {
+                                shift_left(self, i+1, 1);
+                                self->num_children--;
+                                self->n--;
+                        } else {
+                                self->children[i] = value;
+                                Py_INCREF(value);
+                        }
+                        DANGER_BEGIN;
+                        Py_DECREF(old_value);
+                        DANGER_END;
+                        return _int(0);
+                }
+
+                if (value == NULL) {
+                        blist_delitem(self, i);
+                        ext_mark_moved(self, i, self->n + 1);
+                        decref_flush();
+                        return _int(0);
+                }
+
+                Py_INCREF(value);
+                old_value = blist_ass_item_return2((PyBListRoot*)self,i,value);
+                DANGER_BEGIN;
+                Py_DECREF(old_value);
+                DANGER_END;
+                return _int(0);
+        } else if (PySlice_Check(item)) {
+                Py_ssize_t start, stop, step, slicelength;
+
+                ext_mark(self, 0, DIRTY);
+
+#if PY_MAJOR_VERSION < 3 || PY_MAJOR_VERSION == 3 && PY_MINOR_VERSION < 2
+                if (PySlice_GetIndicesEx((PySliceObject*)item, self->n,
+#else
+                if (PySlice_GetIndicesEx(item, self->n,
+#endif
+                                         &start, &stop,&step,&slicelength)<0)
+                        return _int(-1);
+
+                /* treat L[slice(a,b)] = v _exactly_ like L[a:b] = v */
+                if (step == 1 && ((PySliceObject*)item)->step == Py_None)
+                        return _redir(py_blist_ass_slice(oself,start,stop,value));
+
+                /* The slice starts from its lowest index */
+                sorted_prefix_cut(self, step > 0 ? start
+                                  : start + step * (slicelength - 1));
+
+                if (value == NULL) {
+                        /* Delete back-to-front */
+                        Py_ssize_t i, cur;
+
+                        if (slicelength <= 0)
+                                return _int(0);
+
+                        if (step > 0) {
+                                stop = start - 1;
+                                start = start + step*(slicelength-1);
+                                step = -step;
+                        }
+
+                        for (cur = start, i = 0; i < slicelength;
+                             cur += step, i++) {
+                                PyObject *ob = blist_delitem_return(self, cur);
+                                decref_later(ob);
+                        }
+
+                        decref_flush();
+                        ext_mark(self, 0, DIRTY);
+
+                        return _int(0);
+                } else { /* assign slice */
+                        PyObject *ins, *seq;
+                        Py_ssize_t cur, i;
+
+                        DANGER_BEGIN;
+                        seq = PySequence_Fast(value,
+                                  "Must assign iterable to extended slice");
+                        DANGER_END;
+                        if (!seq)
+                                return _int(-1);
+
+                        if (seq == (PyObject *) self) {
+                                Py_DECREF(seq);
+                                seq = (PyObject *) blist_root_copy(self);
+                        }
+
+                        if (PySequence_Fast_GET_SIZE(seq) != slicelength) {
+                                PyErr_Format(PyExc_ValueError,
+                                             "attempt to assign sequence of size %zd to extended slice of size %zd",
+                                             PySequence_Fast_GET_SIZE(seq),
+                                             slicelength);
+                                Py_DECREF(seq);
+                                return _int(-1);
+                        }
+
+                        if (!slicelength) {
+                                Py_DECREF(seq);
+                                return _int(0);
+                        }
+
+                        for (cur = start, i = 0; i < slicelength;
+                             cur += step, i++) {
+                                PyObject *ob;
+                                ins = PySequence_Fast_GET_ITEM(seq, i);
+                                ob = blist_ass_item_return(self, cur, ins);
+                                decref_later(ob);
+                        }
+
+                        Py_DECREF(seq);
+
+                        decref_flush();
+
+                        return _int(0);
+                }
+        } else {
+                PyErr_SetString(PyExc_TypeError,
+                                "list indices must be integers");
+                return _int(-1);
+        }
+}
+
+BLIST_PYAPI(Py_ssize_t)
+py_blist_length(PyObject *ob)
+{
+        assert(PyRootBList_Check(ob));
+        return ((PyBList *) ob)->n;
+}
+
+BLIST_PYAPI(PyObject *)
+py_blist_repeat(PyObject *oself, Py_ssize_t n)
+{
+        PyObject *ret;
+        PyBList *self;
+
+        invariants(oself, VALID_USER|VALID_DECREF);
+
+        self = (PyBList *) oself;
+
+        ret = blist_repeat(self, n);
+        decref_flush();
+        ext_mark_set_dirty_all(self);
+
+        return _ob(ret);
+}
+
+BLIST_PYAPI(PyObject *)
+py_blist_inplace_repeat(PyObject *oself, Py_ssize_t n)
+{
+        PyBList *tmp, *self;
+
+        invariants(oself, VALID_USER|VALID_RW|VALID_DECREF);
+
+        self = (PyBList *) oself;
+
+        tmp = (PyBList *) blist_repeat(self, n);
+        if (tmp == NULL)
+                return (PyObject *) _blist(NULL);
+        blist_become_and_consume(self, tmp);
+        sorted_prefix_cut(self, self->n); /* Repeating by n <= 0 empties */
+        Py_INCREF(self);
+        SAFE_DECREF(tmp);
+
+        decref_flush();
+
+        ext_mark(self, 0, DIRTY);
+
+        return (PyObject *) _blist(self);
+}
+
+BLIST_PYAPI(PyObject *)
+py_blist_extend(PyBList *self, PyObject *other)
+{
+        int err;
+
+        invariants(self, VALID_USER|VALID_RW|VALID_DECREF);
+
+        err = blist_extend(self, other);
+        decref_flush();
+        ext_mark(self, 0, DIRTY);
+        if (PyBList_Check(other))
+                ext_mark_set_dirty_all((PyBList *) other);
+
+        if (err < 0)
+                return _ob(NULL);
+        Py_RETURN_NONE;
+}
+
+BLIST_PYAPI(PyObject *)
+py_blist_extendleft(PyBList *self, PyObject *other)
+{
+        PyBList *items, *right;
+        int err;
+
+        invariants(self, VALID_USER|VALID_RW|VALID_DECREF);
+
+        items = blist_root_new();
+        if (items == NULL)
+                return _ob(NULL);
+        err = blist_init_from_seq(items, other);
+        if (err < 0 || items->n == 0)
+                goto done;
+
+        if (items->leaf)
+                reverse_slice(items->children,
+                              &items->children[items->num_children]);
+        else
+                blist_reverse((PyBListRoot *) items);
+
+        /* As in py_blist_ass_slice(), splice items in front */
+        sorted_prefix_cut(self, 0);
+        right = blist_root_copy(self);
+        if (right == NULL) {
+                err = -1;
+                goto done;
+        }
+        blist_delslice(self, 0, self->n);
+        err = blist_extend_blist(self, items);
+        if (err >= 0)
+                err = blist_extend_blist(self, right);
+        ext_mark(self, 0, DIRTY);
+        SAFE_DECREF(right);
+
+ done:
+        SAFE_DECREF(items);
+        decref_flush();
+        if (err < 0)
+                return _ob(NULL);
+        Py_RETURN_NONE;
+}
+
+BLIST_PYAPI(PyObject *)
+py_blist_inplace_concat(PyObject *oself, PyObject *other)
+{
+        int err;
+        PyBList *self;
+
+        invariants(oself, VALID_RW|VALID_USER|VALID_DECREF);
+
+        self = (PyBList *) oself;
+
+        err = blist_extend(self, other);
+        decref_flush();
+        ext_mark(self, 0, DIRTY);
+        if (PyBList_Check(other))
+                ext_mark_set_dirty_all((PyBList*) other);
+
+        if (err < 0)
+                return _ob(NULL);
+
+        Py_INCREF(self);
+        return _ob((PyObject *)self);
+}
+
+BLIST_PYAPI(int)
+py_blist_contains(PyObject *oself, PyObject *el)
+{
+        int c, ret = 0;
+        PyObject *item;
+        PyBList *self;
+        fast_compare_data_t fast_cmp_type;
+
+        invariants(oself, VALID_USER | VALID_DECREF);
+
+        self = (PyBList *) oself;
+        fast_cmp_type = check_fast_cmp_type(el, Py_EQ);
+
+        ITER(self, item, {
+                c = fast_eq(el, item, fast_cmp_type);
+                if (c < 0) {
+                        ret = -1;
+                        break;
+                }
+                if (c > 0) {
+                        ret = 1;
+                        break;
+                }
+        });
+
+        decref_flush();
+        return _int(ret);
+}
+
+/* Return a new root holding self[ilow:ihigh], sharing self's nodes.
+ * 0 <= ilow, ihigh <= self->n.  Returns NULL on failure. */
+BLIST_LOCAL(PyBList *)
+blist_root_slice(PyBList *self, Py_ssize_t ilow, Py_ssize_t ihigh)
+{
+        PyBList *rv;
+
+        invariants(self, VALID_ROOT);
+
+        rv = blist_root_new();
+        if (rv == NULL)
+                return _blist(NULL);
+
+        if (ihigh <= ilow || ilow >= self->n)
+                return _blist(rv);
+
+        if (blist_root_reserve(rv, self->leaf ? ihigh - ilow : LIMIT) < 0) {
+                SAFE_DECREF(rv);
+                return _blist(NULL);
+        }
+
+        if (self->leaf) {
+                Py_ssize_t delta = ihigh - ilow;
+
+                copyref(rv, 0, self, ilow, delta);
+                rv->num_children = delta;
+                rv->n = delta;
+                return _blist(rv);
+        }
+
+        blist_become(rv, self);
+        blist_delslice(rv, ihigh, self->n);
+        blist_delslice(rv, 0, ilow);
+
+        ext_mark(rv, 0, DIRTY);
+        ext_mark_set_dirty(self, ilow, ihigh);
+
+        return _blist(rv);
+}
+
+/* Reorder self[lo:hi] so that the items from mid onwards come first:
+ * with B = self[lo:mid] and C = self[mid:hi], "A B C D" becomes
+ * "A C B D".  The pieces are split off as shared slices and
+ * concatenated again, so only the nodes along the cuts are touched:
+ * O(log n), however many items move.  Returns -1 on failure.
+ */
+BLIST_LOCAL(int)
+blist_rotate_range(PyBList *self, Py_ssize_t lo, Py_ssize_t mid,
+                   Py_ssize_t hi)
+{
+        PyBList *b, *c, *d;
+        int err = 0;
+
+        invariants(self, VALID_ROOT|VALID_RW);
+        assert(0 <= lo && lo <= mid && mid <= hi && hi <= self->n);
+
+        if (lo == mid || mid == hi)
+                return _int(0);
+
+        if (self->leaf) {
+                reverse_slice(&self->children[lo], &self->children[hi]);
+                reverse_slice(&self->children[lo],
+                              &self->children[lo + hi - mid]);
+                reverse_slice(&self->children[lo + hi - mid],
+                              &self->children[hi]);
+                return _int(0);
+        }
+
+        b = blist_root_slice(self, lo, mid);
+        c = blist_root_slice(self, mid, hi);
+        d = blist_root_slice(self, hi, self->n);
+        if (b == NULL || c == NULL || d == NULL) {
+                err = -1;
+                goto done;
+        }
+
+        blist_delslice(self, lo, self->n);
+        err = blist_extend_blist(self, c);
+        if (err >= 0)
+                err = blist_extend_blist(self, b);
+        if (err >= 0 && d->n)
+                err = blist_extend_blist(self, d);
+        ext_mark(self, 0, DIRTY);
+
+ done:
+        SAFE_XDECREF(b);
+        SAFE_XDECREF(c);
+        SAFE_XDECREF(d);
+        return _int(err);
+}
+
+BLIST_PYAPI(PyObject *)
+py_blist_get_slice(PyObject *oself, Py_ssize_t ilow, Py_ssize_t ihigh)
+{
+        PyBList *rv, *self;
+
+        invariants(oself, VALID_USER | VALID_DECREF);
+
+        self = (PyBList *) oself;
+
+        if (ilow < 0) ilow = 0;
+        else if (ilow > self->n) ilow = self->n;
+        if (ihigh < ilow) ihigh = ilow;
+        else if (ihigh > self->n) ihigh = self->n;
+
+        rv = blist_root_slice(self, ilow, ihigh);
+        decref_flush();
+
+        return (PyObject *) _blist(rv);
+}
+
+/* This should only be called by _PyBList_GET_ITEM_FAST2() */
+PyObject *_PyBList_GetItemFast3(PyBListRoot *root, Py_ssize_t i)
+{
+        PyObject *rv;
+        Py_ssize_t dirty_offset = -1;
+
+        invariants(root, VALID_PARENT);
+        assert(!root->leaf);
+        assert(root->dirty_root != CLEAN);
+        assert(i >= 0);
+        assert(i < root->n);
+
+        if (EXT_FINGER_HAS(root, i))
+                return _ob(root->finger->children[i - root->finger_offset]);
+
+        if (!ext_want_index(root)) {
+                Py_ssize_t offset;
+                int setclean;
+                PyBList *p = ext_find_leaf(root, i, &offset, &setclean);
+
+                ext_set_finger(root, p, offset, setclean);
+                return _ob(p->children[i - offset]);
+        }
+
+        if (ext_is_dirty(root, i, &dirty_offset)){
+                rv = ext_make_clean(root, i, 1);
+        } else {
+                Py_ssize_t ioffset = i / INDEX_FACTOR;
+                Py_ssize_t offset = root->offset_list[ioffset];
+                PyBList *p = root->index_list[ioffset];
+                assert(i >= offset);
+                assert(p);
+                assert(p->leaf);
+                if (i < offset + p->n) {
+                        rv = p->children[i - offset];
+                        if (dirty_offset >= 0)
+                                ext_make_clean(root, dirty_offset, 0);
+                } else if (ext_is_dirty(root,i + INDEX_FACTOR,&dirty_offset)){
+                        rv = ext_make_clean(root, i, 1);
+                } else {
+                        ioffset++;
+                        assert(ioffset < root->index_allocated);
+                        offset = root->offset_list[ioffset];
+                        p = root->index_list[ioffset];
+                        rv = p->children[i - offset];
+                        assert(p);
+                        assert(p->leaf);
+                        assert(i < offset + p->n);
+                        if (dirty_offset >= 0)
+                                ext_make_clean(root, dirty_offset, 0);
+                }
+        }
+
+        assert(rv == blist_get1((PyBList *)root, i));
+
+        return _ob(rv);
+}
+
+/* For extension modules that process a blist a leaf at a time.  Points
+ * *pitems at the contiguous run of items from position i to the end of
+ * the leaf holding it, and returns the run's length (0 if i is out of
+ * range).  The items are borrowed and only valid until the list is
+ * next modified. */
+Py_ssize_t _PyBList_GetChunk(PyBListRoot *root, Py_ssize_t i,
+                             PyObject ***pitems)
+{
+        PyBList *p;
+        Py_ssize_t offset;
+        int setclean;
+
+        invariants(root, VALID_PARENT);
+
+        if (i < 0 || i >= root->n) {
+                *pitems = NULL;
+                return _int(0);
+        }
+
+        if (root->leaf) {
+                p = (PyBList *) root;
+                offset = 0;
+        } else
+                p = ext_find_leaf(root, i, &offset, &setclean);
+
+        *pitems = &p->children[i - offset];
+        return _int(p->n - (i - offset));
+}
+
+BLIST_PYAPI(PyObject *)
+py_blist_get_item(PyObject *oself, Py_ssize_t i)
+{
+        PyBList *self = (PyBList *) oself;
+        PyObject *ret;
+
+        invariants(self, VALID_USER);
+
+        if (i < 0 || i >= self->n) {
+                set_index_error();
+                return _ob(NULL);
+        }
+
+        if (self->leaf)
+                ret = self->children[i];
+        else
+                ret = _PyBList_GET_ITEM_FAST2((PyBListRoot*)self, i);
+        Py_INCREF(ret);
+        return _ob(ret);
+}
+
+/* Note: this may be called as __radd__, which means the arguments may
+ * be reversed. */
+BLIST_PYAPI(PyObject *)
+py_blist_concat(PyObject *ob1, PyObject *ob2)
+{
+        PyBList *rv;
+        int err;
+
+        int is_blist1 = PyRootBList_Check(ob1);
+        int is_blist2 = PyRootBList_Check(ob2);
+
+        if ((!is_blist1 && !PyList_Check(ob1))
+            || (!is_blist2 && !PyList_Check(ob2))) {
+                Py_INCREF(Py_NotImplemented);
+                return Py_NotImplemented;
+        }
+
+        if (is_blist1 && is_blist2) {
+                PyBList *blist1 = (PyBList *) ob1;
+                PyBList *blist2 = (PyBList *) ob2;
+                if (blist1->n < LIMIT && blist2->n < LIMIT
+                    && blist1->n + blist2->n < LIMIT) {
+                        rv = blist_root_new();
+                        if (rv != NULL && blist_root_reserve(
+                                    rv, blist1->n + blist2->n) < 0) {
+                                decref_later((PyObject *) rv);
+                                rv = NULL;
+                        }
+                        if (rv == NULL)
+                                goto done;
+                        copyref(rv, 0, blist1, 0, blist1->n);
+                        copyref(rv, blist1->n, blist2, 0, blist2->n);
+                        rv->n = rv->num_children = blist1->n + blist2->n;
+                        goto done;
+                }
+
+                rv = blist_root_copy(blist1);
+                if (rv == NULL)
+                        goto done;
+                blist_extend_blist(rv, blist2);
+                ext_mark(rv, 0, DIRTY);
+                ext_mark_set_dirty_all(blist2);
+                goto done;
+        }
+
+        rv = blist_root_new();
+        err = blist_init_from_seq(rv, ob1);
+        if (err < 0) {
+                decref_later((PyObject *) rv);
+                rv = NULL;
+                goto done;
+        }
+        err = blist_extend(rv, ob2);
+        if (err < 0) {
+                decref_later((PyObject *) rv);
+                rv = NULL;
+                goto done;
+        }
+        ext_mark(rv, 0, DIRTY);
+        if (PyBList_Check(ob1))
+                ext_mark_set_dirty_all((PyBList *) ob1);
+        if (PyBList_Check(ob2))
+                ext_mark_set_dirty_all((PyBList *) ob2);
+
+done:
+        _decref_flush();
+        return (PyObject *) rv;
+}
+
+/* User-visible repr() */
+BLIST_PYAPI(PyObject *)
+py_blist_repr(PyObject *oself)
+{
+        /* Basic approach: Clone self in O(1) time, then walk through
+         * the clone, changing each element to repr() of the element,
+         * in O(n) time.  Finally, enclose it in square brackets and
+         * call join.
+         */
+
+        Py_ssize_t i;
+        PyBList *pieces = NULL, *self;
+        PyObject *result = NULL;
+        PyObject *s, *tmp, *tmp2;
+
+        invariants(oself, VALID_USER);
+        self = (PyBList *) oself;
+
+        DANGER_BEGIN;
+        i = Py_ReprEnter((PyObject *) self);
+        DANGER_END;
+        if (i) {
+                return i > 0 ? _ob(PyUnicode_FromString("[...]")) : _ob(NULL);
+        }
+
+        if (self->n == 0) {
+#ifdef Py_BUILD_CORE
+                result = PyUnicode_FromString("[]");
+#else
+                result = PyUnicode_FromString("blist([])");
+#endif
+                goto Done;
+        }
+
+        pieces = blist_root_copy(self);
+        if (pieces == NULL)
+                goto Done;
+
+        if (blist_repr_r(pieces) < 0)
+                goto Done;
+
+#ifdef Py_BUILD_CORE
+        s = PyUnicode_FromString("[");
+#else
+        s = PyUnicode_FromString("blist([");
+#endif
+        if (s == NULL)
+                goto Done;
+        tmp = blist_get1(pieces, 0);
+        tmp2 = PyUnicode_Concat(s, tmp);
+        Py_DECREF(s);
+        s = tmp2;
+        DANGER_BEGIN;
+        py_blist_ass_item((PyObject *) pieces, 0, s);
+        DANGER_END;
+        Py_DECREF(s);
+
+#ifdef Py_BUILD_CORE
+        s = PyUnicode_FromString("]");
+#else
+        s = PyUnicode_FromString("])");
+#endif
+        if (s == NULL)
+                goto Done;
+        tmp = blist_get1(pieces, pieces->n-1);
+        tmp2 = PyUnicode_Concat(tmp, s);
+        Py_DECREF(s);
+        tmp = tmp2;
+        DANGER_BEGIN;
+        py_blist_ass_item((PyObject *) pieces, pieces->n-1, tmp);
+        DANGER_END;
+        Py_DECREF(tmp);
+
+        s = PyUnicode_FromString(", ");
+        if (s == NULL)
+                goto Done;
+        result = PyUnicode_Join(s, (PyObject *) pieces);
+        Py_DECREF(s);
+
+ Done:
+        DANGER_BEGIN;
+        /* Only deallocating strings, so this is safe */
+        Py_XDECREF(pieces);
+        DANGER_END;
+
+        DANGER_BEGIN;
+        Py_ReprLeave((PyObject *) self);
+        DANGER_END;
+        return _ob(result);
+}
+
+#if defined(Py_DEBUG) && !defined(BLIST_IN_PYTHON)
+/* Return a string that shows the internal structure of the BList */
+BLIST_PYAPI(PyObject *)
+blist_debug(PyBList *self, PyObject *indent)
+{
+        PyObject *result, *s, *nl_indent, *comma, *indent2, *tmp, *tmp2;
+
+        invariants(self, VALID_PARENT);
+
+        comma = PyUnicode_FromString(", ");
+
+        if (indent == NULL)
+                indent = PyUnicode_FromString("");
+        else
+                Py_INCREF(indent);
+
+        tmp = PyUnicode_FromString("  ");
+        indent2 = PyUnicode_Concat(indent, tmp);
+        Py_DECREF(tmp);
+
+        if (!self->leaf) {
+                int i;
+
+                nl_indent = indent2;
+                tmp = PyUnicode_FromString("\n");
+                nl_indent = PyUnicode_Concat(indent2, tmp);
+                Py_DECREF(tmp);
+
+                result = PyUnicode_FromFormat("blist(leaf=%d, n=%d, r=%d, ",
+                                             self->leaf, self->n,
+                                             Py_REFCNT(self));
+                /* PyUnicode_Concat(&result, nl_indent); */
+
+                for (i = 0; i < self->num_children; i++) {
+                        s = blist_debug((PyBList *)self->children[i], indent2);
+                        tmp = PyUnicode_Concat(result, nl_indent);
+                        Py_DECREF(result);
+                        result = tmp;
+                        tmp = PyUnicode_Concat(result, s);
+                        Py_DECREF(result);
+                        result = tmp;
+                        Py_DECREF(s);
+                }
+
+                tmp = PyUnicode_FromString(")");
+                tmp2 = PyUnicode_Concat(result, tmp);
+                Py_DECREF(result);
+                Py_DECREF(tmp);
+                result = tmp2;
+        } else {
+                int i;
+
+                result = PyUnicode_FromFormat("blist(leaf=%d, n=%d, r=%d, ",
+                                             self->leaf, self->n,
+                                             Py_REFCNT(self));
+                for (i = 0; i < self->num_children; i++) {
+                        s = PyObject_Str(self->children[i]);
+                        tmp = PyUnicode_Concat(result, s);
+                        Py_DECREF(result);
+                        result = tmp;
+                        Py_DECREF(s);
+                        tmp = PyUnicode_Concat(result, comma);
+                        Py_DECREF(result);
+                        result = tmp;
+                }
+        }
+
+        s = indent;
+        tmp = PyUnicode_Concat(s, result);
+        Py_DECREF(result);
+        result = tmp;
+
+        Py_DECREF(comma);
+        Py_DECREF(indent);
+        check_invariants(self);
+        return _ob(result);
+}
+
+BLIST_PYAPI(PyObject *)
+py_blist_debug(PyBList *self)
+{
+        invariants(self, VALID_USER);
+        return _ob(blist_debug(self, NULL));
+}
+#endif
+
+BLIST_PYAPI(PyObject *)
+py_blist_sort(PyBListRoot *self, PyObject *args, PyObject *kwds)
+{
+#if PY_MAJOR_VERSION < 3
+        static char *kwlist[] = {"cmp", "key", "reverse", 0};
+#else
+        static char *kwlist[] = {"key", "reverse", 0};
+#endif
+        int reverse = 0, plain;
+        int ret = -1;
+        PyBListRoot saved;
+        PyObject *result = NULL;
+        PyObject *compare = NULL, *keyfunc = NULL;
+        static PyObject **extra_list = NULL;
+
+        invariants(self, VALID_USER|VALID_RW | VALID_DECREF);
+
+        if (args != NULL) {
+                int err;
+                DANGER_BEGIN;
+#if PY_MAJOR_VERSION < 3
+                err = PyArg_ParseTupleAndKeywords(args, kwds, "|OOi:sort",
+                                                  kwlist, &compare, &keyfunc,
+                                                  &reverse);
+                DANGER_END;
+                if (!err)
+                        return _ob(NULL);
+#else
+                err = PyArg_ParseTupleAndKeywords(args, kwds, "|Oi:sort",
+                                                  kwlist, &keyfunc, &reverse);
+                DANGER_END;
+                if (!err)
+                        return _ob(NULL);
+                if (Py_SIZE(args) > 0) {
+                        PyErr_SetString(PyExc_TypeError,
+                                "must use keyword argument for key function");
+                        return _ob(NULL);
+                }
+#endif
+        }
+
+        if (self->n < 2)
+                Py_RETURN_NONE;
+
+#if PY_MAJOR_VERSION < 3
+        if (is_default_cmp(compare))
+                compare = NULL;
+#endif
+        if (keyfunc == Py_None)
+                keyfunc = NULL;
+
+        plain = compare == NULL && keyfunc == NULL && !reverse;
+        if (plain && self->sorted_n == self->n)
+                Py_RETURN_NONE;
+
+        memset(&saved, 0, offsetof(PyBListRoot, BLIST_FIRST_FIELD));
+        memcpy(&saved.BLIST_FIRST_FIELD, &self->BLIST_FIRST_FIELD,
+               sizeof(*self) - offsetof(PyBListRoot, BLIST_FIRST_FIELD));
+        Py_TYPE(&saved) = &PyRootBList_Type;
+        Py_REFCNT(&saved) = 1;
+        self->sizes = NULL;
+        self->sizes_valid = 0;
+        self->sizes_allocated = 0;
+
+        if (extra_list != NULL) {
+                self->children = extra_list;
+                extra_list = NULL;
+        } else {
+                self->children = children_new();
+                if (self->children == NULL)
+                        goto err;
+        }
+        self->allocated = LIMIT;
+        self->n = 0;
+        self->num_children = 0;
+        self->leaf = 1;
+        ext_init(self);
+
+        /* Reverse sort stability achieved by initially reversing the list,
+           applying a stable forward sort, then reversing the final result. */
+        if (reverse)
+                blist_reverse(&saved);
+
+        /* Only a few items appended since the last sort? */
+        if (plain && saved.sorted_n
+            && (saved.n - saved.sorted_n) * 8 < saved.n)
+                ret = sort_tail(&saved);
+        else
+                ret = sort(&saved, compare, keyfunc, NULL);
+
+        if (ret >= 0) {
+                result = Py_None;
+                if (reverse) {
+                        ext_mark((PyBList*)&saved, 0, DIRTY);
+                        blist_reverse(&saved);
+                        saved.sorted_n = 0;
+                }
+        } else
+                ext_mark((PyBList*)&saved, 0, DIRTY);
+
+        if (self->n && saved.n) {
+                DANGER_BEGIN;
+                /* An error may also have been raised by a comparison
+                 * function.  Since this may decref that traceback, it can
+                 * execute arbitrary python code. */
+                PyErr_SetString(PyExc_ValueError, "list modified during sort");
+                DANGER_END;
+                result = NULL;
+                blist_CLEAR((PyBList*) self);
+        }
+
+        if (extra_list == NULL && self->allocated == LIMIT)
+                extra_list = self->children;
+        else
+                root_children_free(self);
+        PyMem_Free(self->sizes);
+
+        ext_dealloc(self);
+        assert(!self->n);
+  err:
+        memcpy(&self->BLIST_FIRST_FIELD, &saved.BLIST_FIRST_FIELD,
+               sizeof(*self) - offsetof(PyBListRoot, BLIST_FIRST_FIELD));
+
+        Py_XINCREF(result);
+
+        decref_flush();
+
+        /* This must come after the decref_flush(); otherwise, we may have
+         * extra temporary references to internal nodes, which throws off the
+         * debug-mode sanity checking. */
+        if (ret >= 0)
+                ext_reindex_set_all(self);
+
+        return _ob(result);
+}
+
+BLIST_PYAPI(PyObject *)
+py_blist_argsort(PyBListRoot *self, PyObject *args, PyObject *kwds)
+{
+        static char *kwlist[] = {"key", "reverse", 0};
+        int reverse = 0;
+        int ret = -1;
+        int err;
+        Py_ssize_t i, n;
+        PyObject *keyfunc = NULL, *item;
+        PyObject **keys = NULL, **indices = NULL;
+        PyBListRoot *snapshot, *result;
+
+        invariants(self, VALID_USER|VALID_DECREF);
+
+        DANGER_BEGIN;
+        err = PyArg_ParseTupleAndKeywords(args, kwds, "|Oi:argsort", kwlist,
+                                          &keyfunc, &reverse);
+        DANGER_END;
+        if (!err)
+                return _ob(NULL);
+        if (keyfunc == Py_None)
+                keyfunc = NULL;
+
+        /* The key function may modify self, so sort a snapshot's keys */
+        snapshot = (PyBListRoot *) blist_root_copy((PyBList *) self);
+        result = (PyBListRoot *) blist_root_new();
+        if (snapshot == NULL || result == NULL)
+                goto done;
+        if (reverse)
+                blist_reverse(snapshot);
+
+        n = snapshot->n;
+        keys = PyMem_New(PyObject *, n);
+        indices = PyMem_New(PyObject *, n);
+        if (keys == NULL || indices == NULL) {
+                PyErr_NoMemory();
+                goto done;
         }
 
-        left = self;
-        right = blist_root_copy(self);
-        blist_delslice(left, ilow, left->n);
-        blist_delslice(right, 0, ihigh);
-        blist_extend_blist(left, other); /* XXX check return values */
-        blist_extend_blist(left, right);
+        i = 0;
+        ITER((PyBList *) snapshot, item, {
+                keys[i++] = item;
+        });
+        for (i = 0; i < n; i++) {
+                indices[i] = PyInt_FromSsize_t(reverse ? n-1-i : i);
+                if (indices[i] == NULL) {
+                        while (i--)
+                                Py_DECREF(indices[i]);
+                        goto done;
+                }
+        }
+        ret = blist_init_from_array((PyBList *) result, indices, n);
+        for (i = 0; i < n; i++)
+                Py_DECREF(indices[i]);
+        if (ret < 0)
+                goto done;
 
-        ext_mark(self, 0, DIRTY);
+        /* Reverse sort stability as in py_blist_sort */
+        ret = sort(result, NULL, keyfunc, keys);
+        if (ret >= 0 && reverse) {
+                ext_mark((PyBList *) result, 0, DIRTY);
+                blist_reverse(result);
+        }
 
-        SAFE_DECREF(other);
-        SAFE_DECREF(right);
+  done:
+        PyMem_Free(indices);
+        PyMem_Free(keys);
+        if (snapshot != NULL)
+                decref_later((PyObject *) snapshot);
+        if (ret < 0 && result != NULL) {
+                decref_later((PyObject *) result);
+                result = NULL;
+        }
 
         decref_flush();
 
-        return _int(0);
-}
+        if (result != NULL)
+                ext_reindex_set_all(result);
 
-BLIST_PYAPI(int)
-py_blist_ass_subscript(PyObject *oself, PyObject *item, PyObject *value)
-{
-        PyBList *self;
+        return _ob((PyObject *) result);
+}
 
-        invariants(oself, VALID_USER|VALID_RW|VALID_DECREF);
+/************************************************************************
+ * Selection
+ */
 
-        self = (PyBList *) oself;
+/* Return 1 if item a comes before item b in a stable sort by keys, 0
+ * if not, or -1 on error.  Ties are broken by position, so the order is
+ * total.  If reverse, larger keys come first.
+ */
+BLIST_LOCAL_INLINE(int)
+select_before(PyObject **keys, Py_ssize_t a, Py_ssize_t b, int reverse,
+              fast_compare_data_t fast_cmp_type)
+{
+        PyObject *x = keys[a], *y = keys[b];
+        int c;
 
-        if (PyIndex_Check(item)) {
-                Py_ssize_t i;
-                PyObject *old_value;
+        if (reverse) {
+                x = keys[b];
+                y = keys[a];
+        }
+        c = fast_lt(x, y, fast_cmp_type);
+        if (c)
+                return c;
+        c = fast_lt(y, x, fast_cmp_type);
+        if (c)
+                return c < 0 ? -1 : 0;
+        return a < b;
+}
 
-                if (PyLong_CheckExact(item)) {
-                        i = PyInt_AsSsize_t(item);
-                        if (i == -1 && PyErr_Occurred()) {
-                                PyErr_Clear();
-                                goto number;
-                        }
-                } else {
-                number:
-                        i = PyNumber_AsSsize_t(item, PyExc_IndexError);
-                        if (i == -1 && PyErr_Occurred())
-                                return _int(-1);
-                }
-                if (i < 0)
-                        i += self->n;
+/* Rearrange the positions in order[lo:hi+1] so that order[k] is the one
+ * a stable sort by keys would put at k, the positions that sort before
+ * it are in order[lo:k], and the rest follow it.  Returns -1 on error.
+ *
+ * This is Floyd and Rivest's selection algorithm.  It first selects
+ * within a sample around k, so that the pivot lands close to k, and
+ * uses about n + min(k, n-k) comparisons on average.
+ */
+BLIST_LOCAL(int)
+quickselect(Py_ssize_t *order, Py_ssize_t lo, Py_ssize_t hi, Py_ssize_t k,
+            PyObject **keys, int reverse, fast_compare_data_t fast_cmp_type)
+{
+        Py_ssize_t i, j, p, t;
+        int c;
 
-                if (i >= self->n || i < 0) {
-                        set_index_error();
-                        return _int(-1);
+#define SELECT_BEFORE(a, b) \
+        select_before(keys, (a), (b), reverse, fast_cmp_type)
+#define SELECT_SWAP(a, b) \
+        (t = order[(a)], order[(a)] = order[(b)], order[(b)] = t)
+
+        while (lo < hi) {
+                if (hi - lo > 600) {
+                        double n = (double) (hi - lo + 1);
+                        double m = (double) (k - lo + 1);
+                        double z = log(n);
+                        double s = 0.5 * exp(2.0 * z / 3.0);
+                        double sd = 0.5 * sqrt(z * s * (n - s) / n);
+                        Py_ssize_t sample_lo, sample_hi;
+
+                        if (m < n / 2)
+                                sd = -sd;
+                        sample_lo = (Py_ssize_t) (k - m * s / n + sd);
+                        sample_hi = (Py_ssize_t) (k + (n - m) * s / n + sd);
+                        if (sample_lo < lo)
+                                sample_lo = lo;
+                        if (sample_hi > hi)
+                                sample_hi = hi;
+                        if (quickselect(order, sample_lo, sample_hi, k, keys,
+                                        reverse, fast_cmp_type) < 0)
+                                return -1;
                 }
 
-                if (self->leaf) {
-                        /* Speed up common cases */
-
-                        old_value = self->children[i];
-                        if (value == NULL) {
-                                shift_left(self, i+1, 1);
-                                self->num_children--;
-                                self->n--;
-                        } else {
-                                self->children[i] = value;
-                                Py_INCREF(value);
-                        }
-                        DANGER_BEGIN;
-                        Py_DECREF(old_value);
-                        DANGER_END;
-                        return _int(0);
+                /* Partition around p, with order[lo] and order[hi] as
+                 * sentinels */
+                p = order[k];
+                SELECT_SWAP(lo, k);
+                if ((c = SELECT_BEFORE(p, order[hi])) < 0)
+                        return -1;
+                if (c)
+                        SELECT_SWAP(hi, lo);
+                i = lo;
+                j = hi;
+                while (i < j) {
+                        SELECT_SWAP(i, j);
+                        i++;
+                        j--;
+                        while ((c = SELECT_BEFORE(order[i], p)) > 0)
+                                i++;
+                        if (c < 0)
+                                return -1;
+                        while ((c = SELECT_BEFORE(p, order[j])) > 0)
+                                j--;
+                        if (c < 0)
+                                return -1;
                 }
-
-                if (value == NULL) {
-                        blist_delitem(self, i);
-                        ext_mark(self, 0, DIRTY);
-                        decref_flush();
-                        return _int(0);
+                if (order[lo] == p)
+                        SELECT_SWAP(lo, j);
+                else {
+                        j++;
+                        SELECT_SWAP(j, hi);
                 }
 
-                Py_INCREF(value);
-                old_value = blist_ass_item_return2((PyBListRoot*)self,i,value);
-                DANGER_BEGIN;
-                Py_DECREF(old_value);
-                DANGER_END;
-                return _int(0);
-        } else if (PySlice_Check(item)) {
-                Py_ssize_t start, stop, step, slicelength;
-
-                ext_mark(self, 0, DIRTY);
-
-#if PY_MAJOR_VERSION < 3 || PY_MAJOR_VERSION == 3 && PY_MINOR_VERSION < 2
-                if (PySlice_GetIndicesEx((PySliceObject*)item, self->n,
-#else
-                if (PySlice_GetIndicesEx(item, self->n,
-#endif
-                                         &start, &stop,&step,&slicelength)<0)
-                        return _int(-1);
+                if (j <= k)
+                        lo = j + 1;
+                if (k <= j)
+                        hi = j - 1;
+        }
 
-                /* treat L[slice(a,b)] = v _exactly_ like L[a:b] = v */
-                if (step == 1 && ((PySliceObject*)item)->step == Py_None)
-                        return _redir(py_blist_ass_slice(oself,start,stop,value));
+#undef SELECT_BEFORE
+#undef SELECT_SWAP
 
-                if (value == NULL) {
-                        /* Delete back-to-front */
-                        Py_ssize_t i, cur;
+        return 0;
+}
 
-                        if (slicelength <= 0)
-                                return _int(0);
+/* Shared by nsmallest(), nlargest() and select().  If nth, returns the
+ * item that a stable sort of self by keyfunc would put at position k.
+ * Otherwise, returns a new blist of the first k items of that sort.
+ * If reverse, the sort is in descending order.
+ *
+ * The k items are chosen with quickselect and then sorted, so this
+ * takes O(n + k log k) comparisons on average.
+ */
+static PyObject *
+blist_select(PyBListRoot *self, Py_ssize_t k, PyObject *keyfunc,
+             int reverse, int nth)
+{
+        Py_ssize_t i, j, n, nkeys = 0;
+        PyObject *item, *rv = NULL;
+        PyObject **keys = NULL, **values = NULL;
+        Py_ssize_t *order = NULL;
+        PyBListRoot *snapshot, *result = NULL;
+        keyfunc_t kf;
+        int ret = -1;
 
-                        if (step > 0) {
-                                stop = start - 1;
-                                start = start + step*(slicelength-1);
-                                step = -step;
-                        }
+        /* The key function and comparisons may modify self, so select
+         * from a snapshot */
+        snapshot = (PyBListRoot *) blist_root_copy((PyBList *) self);
+        if (snapshot == NULL)
+                goto done;
+        n = snapshot->n;
 
-                        for (cur = start, i = 0; i < slicelength;
-                             cur += step, i++) {
-                                PyObject *ob = blist_delitem_return(self, cur);
-                                decref_later(ob);
-                        }
+        if (nth) {
+                if (k < 0)
+                        k += n;
+                if (k < 0 || k >= n) {
+                        set_index_error();
+                        goto done;
+                }
+        } else {
+                result = (PyBListRoot *) blist_root_new();
+                if (result == NULL)
+                        goto done;
+                if (k > n)
+                        k = n;
+                if (k <= 0) {
+                        ret = 0;
+                        goto done;
+                }
+        }
 
-                        decref_flush();
-                        ext_mark(self, 0, DIRTY);
+        values = PyMem_New(PyObject *, n);
+        keys = PyMem_New(PyObject *, n);
+        order = PyMem_New(Py_ssize_t, n);
+        if (values == NULL || keys == NULL || order == NULL) {
+                PyErr_NoMemory();
+                goto done;
+        }
 
-                        return _int(0);
-                } else { /* assign slice */
-                        PyObject *ins, *seq;
-                        Py_ssize_t cur, i;
+        i = 0;
+        ITER((PyBList *) snapshot, item, {
+                values[i++] = item;
+        });
 
+        keyfunc_init(&kf, keyfunc);
+        for (; nkeys < n; nkeys++) {
+                if (keyfunc == NULL) {
+                        item = values[nkeys];
+                        Py_INCREF(item);
+                } else {
                         DANGER_BEGIN;
-                        seq = PySequence_Fast(value,
-                                  "Must assign iterable to extended slice");
+                        item = keyfunc_call(&kf, values[nkeys]);
                         DANGER_END;
-                        if (!seq)
-                                return _int(-1);
+                        if (item == NULL)
+                                break;
+                }
+                keys[nkeys] = item;
+                order[nkeys] = nkeys;
+        }
+        keyfunc_release(&kf);
+        if (nkeys < n)
+                goto done;
 
-                        if (seq == (PyObject *) self) {
-                                Py_DECREF(seq);
-                                seq = (PyObject *) blist_root_copy(self);
-                        }
+        if (k < n && quickselect(order, 0, n - 1, k, keys, reverse,
+                                 check_fast_cmp_type(keys[0], Py_LT)) < 0)
+                goto done;
 
-                        if (PySequence_Fast_GET_SIZE(seq) != slicelength) {
-                                PyErr_Format(PyExc_ValueError,
-                                             "attempt to assign sequence of size %zd to extended slice of size %zd",
-                                             PySequence_Fast_GET_SIZE(seq),
-                                             slicelength);
-                                Py_DECREF(seq);
-                                return _int(-1);
-                        }
+        if (nth) {
+                rv = values[order[k]];
+                Py_INCREF(rv);
+                ret = 0;
+                goto done;
+        }
 
-                        if (!slicelength) {
-                                Py_DECREF(seq);
-                                return _int(0);
-                        }
+        /* Drop the keys of the items not chosen, then gather the
+         * chosen ones in their original order */
+        for (i = k; i < n; i++) {
+                decref_later(keys[order[i]]);
+                keys[order[i]] = NULL;
+        }
+        for (i = j = 0; i < n; i++) {
+                if (keys[i] == NULL)
+                        continue;
+                keys[j] = keys[i];
+                values[j++] = values[i];
+        }
+        assert(j == k);
+        nkeys = k;
 
-                        for (cur = start, i = 0; i < slicelength;
-                             cur += step, i++) {
-                                PyObject *ob;
-                                ins = PySequence_Fast_GET_ITEM(seq, i);
-                                ob = blist_ass_item_return(self, cur, ins);
-                                decref_later(ob);
-                        }
+        /* Reverse sort stability as in py_blist_sort */
+        if (reverse) {
+                reverse_slice(keys, &keys[k]);
+                reverse_slice(values, &values[k]);
+        }
+        ret = blist_init_from_array((PyBList *) result, values, k);
+        if (ret < 0)
+                goto done;
+        ret = sort(result, NULL, NULL, keys);
+        if (ret >= 0 && reverse) {
+                ext_mark((PyBList *) result, 0, DIRTY);
+                blist_reverse(result);
+        }
+
+  done:
+        for (i = 0; i < nkeys; i++)
+                decref_later(keys[i]);
+        PyMem_Free(order);
+        PyMem_Free(keys);
+        PyMem_Free(values);
+        if (snapshot != NULL)
+                decref_later((PyObject *) snapshot);
+        if (ret < 0) {
+                if (result != NULL)
+                        decref_later((PyObject *) result);
+                result = NULL;
+                rv = NULL;
+        } else if (!nth)
+                rv = (PyObject *) result;
 
-                        Py_DECREF(seq);
+        decref_flush();
 
-                        decref_flush();
+        if (result != NULL)
+                ext_reindex_set_all(result);
 
-                        return _int(0);
-                }
-        } else {
-                PyErr_SetString(PyExc_TypeError,
-                                "list indices must be integers");
-                return _int(-1);
-        }
+        return rv;
 }
 
-BLIST_PYAPI(Py_ssize_t)
-py_blist_length(PyObject *ob)
+BLIST_PYAPI(PyObject *)
+py_blist_nsmallest(PyBListRoot *self, PyObject *args, PyObject *kwds)
 {
-        assert(PyRootBList_Check(ob));
-        return ((PyBList *) ob)->n;
+        static char *kwlist[] = {"k", "key", 0};
+        Py_ssize_t k;
+        PyObject *keyfunc = NULL;
+        int err;
+
+        invariants(self, VALID_USER|VALID_DECREF);
+
+        DANGER_BEGIN;
+        err = PyArg_ParseTupleAndKeywords(args, kwds, "n|O:nsmallest", kwlist,
+                                          &k, &keyfunc);
+        DANGER_END;
+        if (!err)
+                return _ob(NULL);
+        if (keyfunc == Py_None)
+                keyfunc = NULL;
+
+        return _ob(blist_select(self, k, keyfunc, 0, 0));
 }
 
 BLIST_PYAPI(PyObject *)
-py_blist_repeat(PyObject *oself, Py_ssize_t n)
+py_blist_nlargest(PyBListRoot *self, PyObject *args, PyObject *kwds)
 {
-        PyObject *ret;
-        PyBList *self;
+        static char *kwlist[] = {"k", "key", 0};
+        Py_ssize_t k;
+        PyObject *keyfunc = NULL;
+        int err;
 
-        invariants(oself, VALID_USER|VALID_DECREF);
+        invariants(self, VALID_USER|VALID_DECREF);
 
-        self = (PyBList *) oself;
+        DANGER_BEGIN;
+        err = PyArg_ParseTupleAndKeywords(args, kwds, "n|O:nlargest", kwlist,
+                                          &k, &keyfunc);
+        DANGER_END;
+        if (!err)
+                return _ob(NULL);
+        if (keyfunc == Py_None)
+                keyfunc = NULL;
 
-        ret = blist_repeat(self, n);
-        decref_flush();
-        ext_mark_set_dirty_all(self);
+        return _ob(blist_select(self, k, keyfunc, 1, 0));
+}
+
+BLIST_PYAPI(PyObject *)
+py_blist_select(PyBListRoot *self, PyObject *args, PyObject *kwds)
+{
+        static char *kwlist[] = {"k", "key", 0};
+        Py_ssize_t k;
+        PyObject *keyfunc = NULL;
+        int err;
+
+        invariants(self, VALID_USER|VALID_DECREF);
+
+        DANGER_BEGIN;
+        err = PyArg_ParseTupleAndKeywords(args, kwds, "n|O:select", kwlist,
+                                          &k, &keyfunc);
+        DANGER_END;
+        if (!err)
+                return _ob(NULL);
+        if (keyfunc == Py_None)
+                keyfunc = NULL;
 
-        return _ob(ret);
+        return _ob(blist_select(self, k, keyfunc, 0, 1));
 }
 
 BLIST_PYAPI(PyObject *)
-py_blist_inplace_repeat(PyObject *oself, Py_ssize_t n)
+py_blist_reverse(PyBList *restrict self)
 {
-        PyBList *tmp, *self;
-
-        invariants(oself, VALID_USER|VALID_RW|VALID_DECREF);
-
-        self = (PyBList *) oself;
-
-        tmp = (PyBList *) blist_repeat(self, n);
-        if (tmp == NULL)
-                return (PyObject *) _blist(NULL);
-        blist_become_and_consume(self, tmp);
-        Py_INCREF(self);
-        SAFE_DECREF(tmp);
+        invariants(self, VALID_USER|VALID_RW);
 
-        decref_flush();
+        sorted_prefix_cut(self, 0);
 
-        ext_mark(self, 0, DIRTY);
+        if (self->leaf)
+                reverse_slice(self->children,
+                              &self->children[self->num_children]);
+        else {
+                blist_reverse((PyBListRoot*) self);
+                if (!EXT_INDEXED((PyBListRoot*) self))
+                        ext_dealloc((PyBListRoot*) self);
+        }
 
-        return (PyObject *) _blist(self);
+        Py_RETURN_NONE;
 }
 
 BLIST_PYAPI(PyObject *)
-py_blist_extend(PyBList *self, PyObject *other)
+py_blist_rotate(PyBList *self, PyObject *args)
 {
+        Py_ssize_t k = 1;
+        Py_ssize_t n = self->n;
         int err;
 
         invariants(self, VALID_USER|VALID_RW|VALID_DECREF);
 
-        err = blist_extend(self, other);
-        decref_flush();
-        ext_mark(self, 0, DIRTY);
-        if (PyBList_Check(other))
-                ext_mark_set_dirty_all((PyBList *) other);
+        DANGER_BEGIN;
+        err = PyArg_ParseTuple(args, "|n:rotate", &k);
+        DANGER_END;
+        if (!err)
+                return _ob(NULL);
+
+        if (n < 2)
+                Py_RETURN_NONE;
+        k %= n;
+        if (k < 0)
+                k += n;
+        if (k == 0)
+                Py_RETURN_NONE;
 
+        sorted_prefix_cut(self, 0);
+        err = blist_rotate_range(self, 0, n - k, n);
+        decref_flush();
         if (err < 0)
                 return _ob(NULL);
         Py_RETURN_NONE;
 }
 
 BLIST_PYAPI(PyObject *)
-py_blist_inplace_concat(PyObject *oself, PyObject *other)
+py_blist_move(PyBList *self, PyObject *args)
 {
+        Py_ssize_t start, stop, dest;
         int err;
-        PyBList *self;
 
-        invariants(oself, VALID_RW|VALID_USER|VALID_DECREF);
+        invariants(self, VALID_USER|VALID_RW|VALID_DECREF);
 
-        self = (PyBList *) oself;
+        DANGER_BEGIN;
+        err = PyArg_ParseTuple(args, "nnn:move", &start, &stop, &dest);
+        DANGER_END;
+        if (!err)
+                return _ob(NULL);
 
-        err = blist_extend(self, other);
-        decref_flush();
-        ext_mark(self, 0, DIRTY);
-        if (PyBList_Check(other))
-                ext_mark_set_dirty_all((PyBList*) other);
+        if (start < 0 && (start += self->n) < 0) start = 0;
+        else if (start > self->n) start = self->n;
+        if (stop < 0 && (stop += self->n) < 0) stop = 0;
+        else if (stop > self->n) stop = self->n;
+        if (dest < 0 && (dest += self->n) < 0) dest = 0;
+        else if (dest > self->n) dest = self->n;
+
+        if (start >= stop || (dest >= start && dest <= stop))
+                Py_RETURN_NONE;
 
+        if (dest < start) {
+                sorted_prefix_cut(self, dest);
+                err = blist_rotate_range(self, dest, start, stop);
+        } else {
+                sorted_prefix_cut(self, start);
+                err = blist_rotate_range(self, start, stop, dest);
+        }
+        decref_flush();
         if (err < 0)
                 return _ob(NULL);
-
-        Py_INCREF(self);
-        return _ob((PyObject *)self);
+        Py_RETURN_NONE;
 }
 
-BLIST_PYAPI(int)
-py_blist_contains(PyObject *oself, PyObject *el)
+BLIST_PYAPI(PyObject *)
+py_blist_split(PyBList *self, PyObject *args)
 {
-        int c, ret = 0;
-        PyObject *item;
-        PyBList *self;
-        fast_compare_data_t fast_cmp_type;
+        Py_ssize_t i;
+        PyBList *left, *right;
+        int err;
 
-        invariants(oself, VALID_USER | VALID_DECREF);
+        invariants(self, VALID_USER|VALID_DECREF);
 
-        self = (PyBList *) oself;
-        fast_cmp_type = check_fast_cmp_type(el, Py_EQ);
+        DANGER_BEGIN;
+        err = PyArg_ParseTuple(args, "n:split", &i);
+        DANGER_END;
+        if (!err)
+                return _ob(NULL);
 
-        ITER(self, item, {
-                c = fast_eq(el, item, fast_cmp_type);
-                if (c < 0) {
-                        ret = -1;
-                        break;
-                }
-                if (c > 0) {
-                        ret = 1;
-                        break;
-                }
-        });
+        if (i < 0 && (i += self->n) < 0) i = 0;
+        else if (i > self->n) i = self->n;
 
+        left = blist_root_slice(self, 0, i);
+        right = blist_root_slice(self, i, self->n);
         decref_flush();
-        return _int(ret);
+        if (left == NULL || right == NULL) {
+                SAFE_XDECREF(left);
+                SAFE_XDECREF(right);
+                decref_flush();
+                return _ob(NULL);
+        }
+
+        return _ob(Py_BuildValue("(NN)", left, right));
 }
 
 BLIST_PYAPI(PyObject *)
-py_blist_get_slice(PyObject *oself, Py_ssize_t ilow, Py_ssize_t ihigh)
+py_blist_partition_chunks(PyBList *self, PyObject *args)
 {
-        PyBList *rv, *self;
+        Py_ssize_t k, j, lo, hi, offset;
+        PyObject *rv;
+        PyBList *p;
+        int err, setclean;
 
-        invariants(oself, VALID_USER | VALID_DECREF);
+        invariants(self, VALID_USER|VALID_DECREF);
 
-        self = (PyBList *) oself;
+        DANGER_BEGIN;
+        err = PyArg_ParseTuple(args, "n:partition_chunks", &k);
+        DANGER_END;
+        if (!err)
+                return _ob(NULL);
 
-        if (ilow < 0) ilow = 0;
-        else if (ilow > self->n) ilow = self->n;
-        if (ihigh < ilow) ihigh = ilow;
-        else if (ihigh > self->n) ihigh = self->n;
+        if (k < 1) {
+                PyErr_SetString(PyExc_ValueError,
+                                "partition_chunks() arg must be positive");
+                return _ob(NULL);
+        }
 
-        rv = blist_root_new();
+        rv = PyTuple_New(k);
         if (rv == NULL)
-                return (PyObject *) _blist(NULL);
-
-        if (ihigh <= ilow || ilow >= self->n)
-                return (PyObject *) _blist(rv);
-
-        if (self->leaf) {
-                Py_ssize_t delta = ihigh - ilow;
+                return _ob(NULL);
 
-                copyref(rv, 0, self, ilow, delta);
-                rv->num_children = delta;
-                rv->n = delta;
-                return (PyObject *) _blist(rv);
+        /* Cut at the ideal boundaries j*n/k, each moved to the nearer
+         * edge of the leaf it falls in when the chunks are large
+         * enough for the skew (at most HALF) not to matter.  Every
+         * chunk is then a run of whole leaves shared with self. */
+        lo = 0;
+        for (j = 1; j <= k; j++) {
+                hi = self->n / k * j + self->n % k * j / k;
+                if (j < k && !self->leaf && self->n / k >= LIMIT) {
+                        p = ext_find_leaf((PyBListRoot *) self, hi,
+                                          &offset, &setclean);
+                        if (hi - offset <= offset + p->n - hi)
+                                hi = offset;
+                        else
+                                hi = offset + p->n;
+                        if (hi < lo)
+                                hi = lo;
+                }
+                p = blist_root_slice(self, lo, hi);
+                if (p == NULL) {
+                        decref_later(rv);
+                        decref_flush();
+                        return _ob(NULL);
+                }
+                PyTuple_SET_ITEM(rv, j - 1, (PyObject *) p);
+                lo = hi;
         }
-
-        blist_become(rv, self);
-        blist_delslice(rv, ihigh, self->n);
-        blist_delslice(rv, 0, ilow);
-
-        ext_mark(rv, 0, DIRTY);
-        ext_mark_set_dirty(self, ilow, ihigh);
         decref_flush();
 
-        return (PyObject *) _blist(rv);
+        return _ob(rv);
 }
 
-/* This should only be called by _PyBList_GET_ITEM_FAST2() */
-PyObject *_PyBList_GetItemFast3(PyBListRoot *root, Py_ssize_t i)
+BLIST_PYAPI(PyObject *)
+py_blist_set_index_policy(PyBListRoot *self, PyObject *args, PyObject *kwds)
 {
+        static char *kwlist[] = {"build", "drop", 0};
+        Py_ssize_t build = self->index_build, drop = self->index_drop;
         PyObject *rv;
-        Py_ssize_t dirty_offset = -1;
+        int err;
 
-        invariants(root, VALID_PARENT);
-        assert(!root->leaf);
-        assert(root->dirty_root != CLEAN);
-        assert(i >= 0);
-        assert(i < root->n);
+        invariants(self, VALID_USER);
 
-        if (ext_is_dirty(root, i, &dirty_offset)){
-                rv = ext_make_clean(root, i);
-        } else {
-                Py_ssize_t ioffset = i / INDEX_FACTOR;
-                Py_ssize_t offset = root->offset_list[ioffset];
-                PyBList *p = root->index_list[ioffset];
-                assert(i >= offset);
-                assert(p);
-                assert(p->leaf);
-                if (i < offset + p->n) {
-                        rv = p->children[i - offset];
-                        if (dirty_offset >= 0)
-                                ext_make_clean(root, dirty_offset);
-                } else if (ext_is_dirty(root,i + INDEX_FACTOR,&dirty_offset)){
-                        rv = ext_make_clean(root, i);
-                } else {
-                        ioffset++;
-                        assert(ioffset < root->index_allocated);
-                        offset = root->offset_list[ioffset];
-                        p = root->index_list[ioffset];
-                        rv = p->children[i - offset];
-                        assert(p);
-                        assert(p->leaf);
-                        assert(i < offset + p->n);
-                        if (dirty_offset >= 0)
-                                ext_make_clean(root, dirty_offset);
-                }
+        rv = Py_BuildValue("(nn)", self->index_build, self->index_drop);
+        if (rv == NULL)
+                return _ob(NULL);
+        DANGER_BEGIN;
+        err = PyArg_ParseTupleAndKeywords(args, kwds, "|nn:set_index_policy",
+                                          kwlist, &build, &drop);
+        DANGER_END;
+        if (!err) {
+                Py_DECREF(rv);
+                return _ob(NULL);
+        }
+        if (build < -1 || drop < 0) {
+                Py_DECREF(rv);
+                PyErr_SetString(PyExc_ValueError, "invalid index policy");
+                return _ob(NULL);
         }
 
-        assert(rv == blist_get1((PyBList *)root, i));
+        if (build != self->index_build) {
+                self->index_build = build;
+                if (!EXT_INDEXED(self))
+                        ext_drop_index(self);
+        }
+        self->index_drop = drop;
+        self->index_idle = 0;
 
         return _ob(rv);
 }
 
 BLIST_PYAPI(PyObject *)
-py_blist_get_item(PyObject *oself, Py_ssize_t i)
+py_blist_count(PyBList *self, PyObject *v)
 {
-        PyBList *self = (PyBList *) oself;
-        PyObject *ret;
+        Py_ssize_t count = 0;
+        PyObject *item;
+        int c;
+        fast_compare_data_t fast_cmp_type;
 
-        invariants(self, VALID_USER);
+        invariants(self, VALID_USER | VALID_DECREF);
 
-        if (i < 0 || i >= self->n) {
-                set_index_error();
+        fast_cmp_type = check_fast_cmp_type(v, Py_EQ);
+
+        ITER(self, item, {
+                c = fast_eq(item, v, fast_cmp_type);
+                if (c > 0)
+                        count++;
+                else if (c < 0) {
+                        ITER_CLEANUP();
+                        decref_flush();
+                        return _ob(NULL);
+                }
+        })
+
+        decref_flush();
+        return _ob(PyInt_FromSsize_t(count));
+}
+
+BLIST_PYAPI(PyObject *)
+py_blist_index(PyBList *self, PyObject *args)
+{
+        Py_ssize_t i, start=0, stop=self->n;
+        PyObject *v;
+        int c, err;
+        PyObject *item;
+        fast_compare_data_t fast_cmp_type;
+
+        invariants(self, VALID_USER|VALID_DECREF);
+
+        DANGER_BEGIN;
+        err = PyArg_ParseTuple(args, "O|O&O&:index", &v,
+                               _PyEval_SliceIndex, &start,
+                               _PyEval_SliceIndex, &stop);
+        DANGER_END;
+        if (!err)
                 return _ob(NULL);
-        }
+        if (start < 0) {
+                start += self->n;
+                if (start < 0)
+                        start = 0;
+        } else if (start > self->n)
+                start = self->n;
+        if (stop < 0) {
+                stop += self->n;
+                if (stop < 0)
+                        stop = 0;
+        } else if (stop > self->n)
+                stop = self->n;
+
+        fast_cmp_type = check_fast_cmp_type(v, Py_EQ);
+        i = start;
+        ITER2(self, item, start, stop, {
+                c = fast_eq(item, v, fast_cmp_type);
+                if (c > 0) {
+                        ITER_CLEANUP();
+                        decref_flush();
+                        return _ob(PyInt_FromSsize_t(i));
+                } else if (c < 0) {
+                        ITER_CLEANUP();
+                        decref_flush();
+                        return _ob(NULL);
+                }
+                i++;
+        })
 
-        if (self->leaf)
-                ret = self->children[i];
-        else
-                ret = _PyBList_GET_ITEM_FAST2((PyBListRoot*)self, i);
-        Py_INCREF(ret);
-        return _ob(ret);
+        decref_flush();
+        PyErr_SetString(PyExc_ValueError, "list.index(x): x not in list");
+        return _ob(NULL);
 }
 
-/* Note: this may be called as __radd__, which means the arguments may
- * be reversed. */
 BLIST_PYAPI(PyObject *)
-py_blist_concat(PyObject *ob1, PyObject *ob2)
+py_blist_remove(PyBList *self, PyObject *v)
 {
-        PyBList *rv;
-        int err;
-
-        int is_blist1 = PyRootBList_Check(ob1);
-        int is_blist2 = PyRootBList_Check(ob2);
+        Py_ssize_t i;
+        int c;
+        PyObject *item;
+        fast_compare_data_t fast_cmp_type;
 
-        if ((!is_blist1 && !PyList_Check(ob1))
-            || (!is_blist2 && !PyList_Check(ob2))) {
-                Py_INCREF(Py_NotImplemented);
-                return Py_NotImplemented;
-        }
+        invariants(self, VALID_USER|VALID_RW|VALID_DECREF);
 
-        if (is_blist1 && is_blist2) {
-                PyBList *blist1 = (PyBList *) ob1;
-                PyBList *blist2 = (PyBList *) ob2;
-                if (blist1->n < LIMIT && blist2->n < LIMIT
-                    && blist1->n + blist2->n < LIMIT) {
-                        rv = blist_root_new();
-                        copyref(rv, 0, blist1, 0, blist1->n);
-                        copyref(rv, blist1->n, blist2, 0, blist2->n);
-                        rv->n = rv->num_children = blist1->n + blist2->n;
-                        goto done;
+        fast_cmp_type = check_fast_cmp_type(v, Py_EQ);
+        i = 0;
+        ITER(self, item, {
+                c = fast_eq(item, v, fast_cmp_type);
+                if (c > 0) {
+                        ITER_CLEANUP();
+                        sorted_prefix_cut(self, i);
+                        blist_delitem(self, i);
+                        ext_mark_moved(self, i, self->n + 1);
+                        decref_flush();
+                        Py_RETURN_NONE;
+                } else if (c < 0) {
+                        ITER_CLEANUP();
+                        decref_flush();
+                        return _ob(NULL);
                 }
+                i++;
+        })
 
-                rv = blist_root_copy(blist1);
-                blist_extend_blist(rv, blist2);
-                ext_mark(rv, 0, DIRTY);
-                ext_mark_set_dirty_all(blist2);
-                goto done;
-        }
-
-        rv = blist_root_new();
-        err = blist_init_from_seq(rv, ob1);
-        if (err < 0) {
-                decref_later((PyObject *) rv);
-                rv = NULL;
-                goto done;
-        }
-        err = blist_extend(rv, ob2);
-        if (err < 0) {
-                decref_later((PyObject *) rv);
-                rv = NULL;
-                goto done;
-        }
-        ext_mark(rv, 0, DIRTY);
-        if (PyBList_Check(ob1))
-                ext_mark_set_dirty_all((PyBList *) ob1);
-        if (PyBList_Check(ob2))
-                ext_mark_set_dirty_all((PyBList *) ob2);
-
-done:
-        _decref_flush();
-        return (PyObject *) rv;
+        decref_flush();
+        PyErr_SetString(PyExc_ValueError, "list.remove(x): x not in list");
+        return _ob(NULL);
 }
 
-/* User-visible repr() */
 BLIST_PYAPI(PyObject *)
-py_blist_repr(PyObject *oself)
+py_blist_pop(PyBList *self, PyObject *args)
 {
-        /* Basic approach: Clone self in O(1) time, then walk through
-         * the clone, changing each element to repr() of the element,
-         * in O(n) time.  Finally, enclose it in square brackets and
-         * call join.
-         */
-
-        Py_ssize_t i;
-        PyBList *pieces = NULL, *self;
-        PyObject *result = NULL;
-        PyObject *s, *tmp, *tmp2;
+        Py_ssize_t i = -1;
+        PyObject *v;
+        int err;
 
-        invariants(oself, VALID_USER);
-        self = (PyBList *) oself;
+        invariants(self, VALID_USER|VALID_RW|VALID_DECREF);
 
         DANGER_BEGIN;
-        i = Py_ReprEnter((PyObject *) self);
+        err = PyArg_ParseTuple(args, "|n:pop", &i);
         DANGER_END;
-        if (i) {
-                return i > 0 ? _ob(PyUnicode_FromString("[...]")) : _ob(NULL);
-        }
+        if (!err)
+                return _ob(NULL);
 
         if (self->n == 0) {
-#ifdef Py_BUILD_CORE
-                result = PyUnicode_FromString("[]");
-#else
-                result = PyUnicode_FromString("blist([])");
-#endif
-                goto Done;
+                /* Special-case most common failure cause */
+                PyErr_SetString(PyExc_IndexError, "pop from empty list");
+                return _ob(NULL);
         }
 
-        pieces = blist_root_copy(self);
-        if (pieces == NULL)
-                goto Done;
-
-        if (blist_repr_r(pieces) < 0)
-                goto Done;
-
-#ifdef Py_BUILD_CORE
-        s = PyUnicode_FromString("[");
-#else
-        s = PyUnicode_FromString("blist([");
-#endif
-        if (s == NULL)
-                goto Done;
-        tmp = blist_get1(pieces, 0);
-        tmp2 = PyUnicode_Concat(s, tmp);
-        Py_DECREF(s);
-        s = tmp2;
-        DANGER_BEGIN;
-        py_blist_ass_item((PyObject *) pieces, 0, s);
-        DANGER_END;
-        Py_DECREF(s);
+        if (i == -1 || i == self->n-1) {
+                sorted_prefix_cut(self, self->n-1);
+                v = blist_pop_last_fast(self);
+                if (v)
+                        return _ob(v);
+        }
 
-#ifdef Py_BUILD_CORE
-        s = PyUnicode_FromString("]");
-#else
-        s = PyUnicode_FromString("])");
-#endif
-        if (s == NULL)
-                goto Done;
-        tmp = blist_get1(pieces, pieces->n-1);
-        tmp2 = PyUnicode_Concat(tmp, s);
-        Py_DECREF(s);
-        tmp = tmp2;
-        DANGER_BEGIN;
-        py_blist_ass_item((PyObject *) pieces, pieces->n-1, tmp);
-        DANGER_END;
-        Py_DECREF(tmp);
+        if (i < 0)
+                i += self->n;
+        if (i < 0 || i >= self->n) {
+                PyErr_SetString(PyExc_IndexError, "pop index out of range");
+                return _ob(NULL);
+        }
 
-        s = PyUnicode_FromString(", ");
-        if (s == NULL)
-                goto Done;
-        result = PyUnicode_Join(s, (PyObject *) pieces);
-        Py_DECREF(s);
+        sorted_prefix_cut(self, i);
+        v = blist_delitem_return(self, i);
+        ext_mark_moved(self, i, self->n + 1);
 
- Done:
-        DANGER_BEGIN;
-        /* Only deallocating strings, so this is safe */
-        Py_XDECREF(pieces);
-        DANGER_END;
+        decref_flush(); /* Remove any deleted BList nodes */
 
-        DANGER_BEGIN;
-        Py_ReprLeave((PyObject *) self);
-        DANGER_END;
-        return _ob(result);
+        return _ob(v); /* the caller now owns the reference the list had */
 }
 
-#if defined(Py_DEBUG) && !defined(BLIST_IN_PYTHON)
-/* Return a string that shows the internal structure of the BList */
 BLIST_PYAPI(PyObject *)
-blist_debug(PyBList *self, PyObject *indent)
+py_blist_popleft(PyBList *self)
 {
-        PyObject *result, *s, *nl_indent, *comma, *indent2, *tmp, *tmp2;
-
-        invariants(self, VALID_PARENT);
-
-        comma = PyUnicode_FromString(", ");
-
-        if (indent == NULL)
-                indent = PyUnicode_FromString("");
-        else
-                Py_INCREF(indent);
-
-        tmp = PyUnicode_FromString("  ");
-        indent2 = PyUnicode_Concat(indent, tmp);
-        Py_DECREF(tmp);
-
-        if (!self->leaf) {
-                int i;
-
-                nl_indent = indent2;
-                tmp = PyUnicode_FromString("\n");
-                nl_indent = PyUnicode_Concat(indent2, tmp);
-                Py_DECREF(tmp);
-
-                result = PyUnicode_FromFormat("blist(leaf=%d, n=%d, r=%d, ",
-                                             self->leaf, self->n,
-                                             Py_REFCNT(self));
-                /* PyUnicode_Concat(&result, nl_indent); */
-
-                for (i = 0; i < self->num_children; i++) {
-                        s = blist_debug((PyBList *)self->children[i], indent2);
-                        tmp = PyUnicode_Concat(result, nl_indent);
-                        Py_DECREF(result);
-                        result = tmp;
-                        tmp = PyUnicode_Concat(result, s);
-                        Py_DECREF(result);
-                        result = tmp;
-                        Py_DECREF(s);
-                }
+        PyBListRoot *root = (PyBListRoot *) self;
+        PyObject *v;
 
-                tmp = PyUnicode_FromString(")");
-                tmp2 = PyUnicode_Concat(result, tmp);
-                Py_DECREF(result);
-                Py_DECREF(tmp);
-                result = tmp2;
-        } else {
-                int i;
+        invariants(self, VALID_USER|VALID_RW|VALID_DECREF);
 
-                result = PyUnicode_FromFormat("blist(leaf=%d, n=%d, r=%d, ",
-                                             self->leaf, self->n,
-                                             Py_REFCNT(self));
-                for (i = 0; i < self->num_children; i++) {
-                        s = PyObject_Str(self->children[i]);
-                        tmp = PyUnicode_Concat(result, s);
-                        Py_DECREF(result);
-                        result = tmp;
-                        Py_DECREF(s);
-                        tmp = PyUnicode_Concat(result, comma);
-                        Py_DECREF(result);
-                        result = tmp;
-                }
+        if (self->n == 0) {
+                PyErr_SetString(PyExc_IndexError, "pop from empty list");
+                return _ob(NULL);
         }
 
-        s = indent;
-        tmp = PyUnicode_Concat(s, result);
-        Py_DECREF(result);
-        result = tmp;
+        /* The rest of a sorted prefix is still sorted */
+        if (root->sorted_n)
+                root->sorted_n--;
 
-        Py_DECREF(comma);
-        Py_DECREF(indent);
-        check_invariants(self);
-        return _ob(result);
+        v = blist_pop_first_fast(self);
+        if (v == NULL) {
+                v = blist_delitem_return(self, 0);
+                ext_mark(self, 0, DIRTY);
+        }
+
+        decref_flush();
+        return _ob(v);
 }
 
 BLIST_PYAPI(PyObject *)
-py_blist_debug(PyBList *self)
+py_blist_clear(PyBList *self)
+{
+        invariants(self, VALID_USER|VALID_RW|VALID_DECREF);
+
+        blist_forget_children(self);
+        self->n = 0;
+        self->leaf = 1;
+        ext_dealloc((PyBListRoot *) self);
+        sorted_prefix_cut(self, 0);
+
+        decref_flush();
+        Py_RETURN_NONE;
+}
+
+BLIST_PYAPI(PyObject *)
+py_blist_copy(PyBList *self)
 {
         invariants(self, VALID_USER);
-        return _ob(blist_debug(self, NULL));
+        return (PyObject *) _blist(blist_root_copy(self));
 }
-#endif
 
 BLIST_PYAPI(PyObject *)
-py_blist_sort(PyBListRoot *self, PyObject *args, PyObject *kwds)
+py_blist_insert(PyBList *self, PyObject *args)
 {
-#if PY_MAJOR_VERSION < 3
-        static char *kwlist[] = {"cmp", "key", "reverse", 0};
-#else
-        static char *kwlist[] = {"key", "reverse", 0};
-#endif
-        int reverse = 0;
-        int ret = -1;
-        PyBListRoot saved;
-        PyObject *result = NULL;
-        PyObject *compare = NULL, *keyfunc = NULL;
-        static PyObject **extra_list = NULL;
+        Py_ssize_t i;
+        PyObject *v;
+        int err;
 
-        invariants(self, VALID_USER|VALID_RW | VALID_DECREF);
+        invariants(self, VALID_USER|VALID_RW);
 
-        if (args != NULL) {
-                int err;
-                DANGER_BEGIN;
-#if PY_MAJOR_VERSION < 3
-                err = PyArg_ParseTupleAndKeywords(args, kwds, "|OOi:sort",
-                                                  kwlist, &compare, &keyfunc,
-                                                  &reverse);
-                DANGER_END;
-                if (!err)
-                        return _ob(NULL);
-#else
-                err = PyArg_ParseTupleAndKeywords(args, kwds, "|Oi:sort",
-                                                  kwlist, &keyfunc, &reverse);
-                DANGER_END;
-                if (!err)
-                        return _ob(NULL);
-                if (Py_SIZE(args) > 0) {
-                        PyErr_SetString(PyExc_TypeError,
-                                "must use keyword argument for key function");
-                        return _ob(NULL);
-                }
-#endif
+        DANGER_BEGIN;
+        err = PyArg_ParseTuple(args, "nO:insert", &i, &v);
+        DANGER_END;
+        if (!err)
+                return _ob(NULL);
+
+        if (self->n == PY_SSIZE_T_MAX) {
+                PyErr_SetString(PyExc_OverflowError,
+                                "cannot add more objects to list");
+                return _ob(NULL);
         }
 
-        if (self->n < 2)
-                Py_RETURN_NONE;
+        if (i < 0) {
+                i += self->n;
+                if (i < 0)
+                        i = 0;
+        } else if (i > self->n)
+                i = self->n;
 
-#if PY_MAJOR_VERSION < 3
-        if (is_default_cmp(compare))
-                compare = NULL;
-#endif
-        if (keyfunc == Py_None)
-                keyfunc = NULL;
+        sorted_prefix_cut(self, i);
+        if (blist_insert_root(self, i, v) < 0)
+                return _ob(NULL);
+        Py_RETURN_NONE;
+}
 
-        memset(&saved, 0, offsetof(PyBListRoot, BLIST_FIRST_FIELD));
-        memcpy(&saved.BLIST_FIRST_FIELD, &self->BLIST_FIRST_FIELD,
-               sizeof(*self) - offsetof(PyBListRoot, BLIST_FIRST_FIELD));
-        Py_TYPE(&saved) = &PyRootBList_Type;
-        Py_REFCNT(&saved) = 1;
+BLIST_PYAPI(PyObject *)
+py_blist_bisect(PyBList *self, PyObject *args, int right)
+{
+        PyObject *key;
+        int keyed = 0, err;
+        Py_ssize_t i;
 
-        if (extra_list != NULL) {
-                self->children = extra_list;
-                extra_list = NULL;
-        } else {
-                self->children = PyMem_New(PyObject *, LIMIT);
-                if (self->children == NULL) {
-                        PyErr_NoMemory();
-                        goto err;
-                }
-        }
-        self->n = 0;
-        self->num_children = 0;
-        self->leaf = 1;
-        ext_init(self);
+        invariants(self, VALID_USER|VALID_DECREF);
 
-        /* Reverse sort stability achieved by initially reversing the list,
-           applying a stable forward sort, then reversing the final result. */
-        if (reverse)
-                blist_reverse(&saved);
+        DANGER_BEGIN;
+        err = PyArg_ParseTuple(args, right ? "O|i:_bisect_right"
+                               : "O|i:_bisect_left", &key, &keyed);
+        DANGER_END;
+        if (!err)
+                return _ob(NULL);
 
-        ret = sort(&saved, compare, keyfunc);
+        i = blist_bisect(self, key, keyed, right);
+        decref_flush();
+        if (i < 0)
+                return _ob(NULL);
+        return _ob(PyInt_FromSsize_t(i));
+}
 
-        if (ret >= 0) {
-                result = Py_None;
-                if (reverse) {
-                        ext_mark((PyBList*)&saved, 0, DIRTY);
-                        blist_reverse(&saved);
-                }
-        } else
-                ext_mark((PyBList*)&saved, 0, DIRTY);
+BLIST_PYAPI(PyObject *)
+py_blist_bisect_left(PyBList *self, PyObject *args)
+{
+        return py_blist_bisect(self, args, 0);
+}
 
-        if (self->n && saved.n) {
-                DANGER_BEGIN;
-                /* An error may also have been raised by a comparison
-                 * function.  Since this may decref that traceback, it can
-                 * execute arbitrary python code. */
-                PyErr_SetString(PyExc_ValueError, "list modified during sort");
-                DANGER_END;
-                result = NULL;
-                blist_CLEAR((PyBList*) self);
-        }
+BLIST_PYAPI(PyObject *)
+py_blist_bisect_right(PyBList *self, PyObject *args)
+{
+        return py_blist_bisect(self, args, 1);
+}
 
-        if (extra_list == NULL)
-                extra_list = self->children;
-        else
-                PyMem_Free(self->children);
+BLIST_PYAPI(PyObject *)
+py_blist_insort(PyBList *self, PyObject *args)
+{
+        PyObject *item, *key;
+        int keyed = 0, err;
+        Py_ssize_t i;
 
-        ext_dealloc(self);
-        assert(!self->n);
-  err:
-        memcpy(&self->BLIST_FIRST_FIELD, &saved.BLIST_FIRST_FIELD,
-               sizeof(*self) - offsetof(PyBListRoot, BLIST_FIRST_FIELD));
+        invariants(self, VALID_USER|VALID_RW|VALID_DECREF);
 
-        Py_XINCREF(result);
+        DANGER_BEGIN;
+        err = PyArg_ParseTuple(args, "O|i:_insort", &item, &keyed);
+        DANGER_END;
+        if (!err)
+                return _ob(NULL);
 
+        if (self->n == PY_SSIZE_T_MAX) {
+                PyErr_SetString(PyExc_OverflowError,
+                                "cannot add more objects to list");
+                return _ob(NULL);
+        }
+
+        key = bisect_key(item, keyed);
+        if (key == NULL)
+                return _ob(NULL);
+        i = blist_bisect(self, key, keyed, 1);
+        decref_later(key);
+        if (i < 0) {
+                decref_flush();
+                return _ob(NULL);
+        }
+
+        sorted_prefix_cut(self, i);
+        err = blist_insert_root(self, i, item);
         decref_flush();
+        if (err < 0)
+                return _ob(NULL);
+        return _ob(PyInt_FromSsize_t(i));
+}
 
-        /* This must come after the decref_flush(); otherwise, we may have
-         * extra temporary references to internal nodes, which throws off the
-         * debug-mode sanity checking. */
-        if (ret >= 0)
-                ext_reindex_set_all(&saved);
+BLIST_PYAPI(PyObject *)
+py_blist_append(PyBList *self, PyObject *v)
+{
+        int err;
 
-        return _ob(result);
+        invariants(self, VALID_USER|VALID_RW);
+
+        err = blist_append(self, v);
+
+        if (err < 0)
+                return _ob(NULL);
+
+        Py_RETURN_NONE;
 }
 
 BLIST_PYAPI(PyObject *)
-py_blist_reverse(PyBList *restrict self)
+py_blist_appendleft(PyBList *self, PyObject *v)
 {
+        int err;
+
         invariants(self, VALID_USER|VALID_RW);
 
-        if (self->leaf)
-                reverse_slice(self->children,
-                              &self->children[self->num_children]);
-        else {
-                blist_reverse((PyBListRoot*) self);
-        }
+        sorted_prefix_cut(self, 0);
+        err = blist_appendleft(self, v);
+
+        if (err < 0)
+                return _ob(NULL);
 
         Py_RETURN_NONE;
 }
 
 BLIST_PYAPI(PyObject *)
-py_blist_count(PyBList *self, PyObject *v)
+py_blist_subscript(PyObject *oself, PyObject *item)
 {
-        Py_ssize_t count = 0;
-        PyObject *item;
-        int c;
-        fast_compare_data_t fast_cmp_type;
+        PyBList *self;
+
+        invariants(oself, VALID_USER);
+
+        self = (PyBList *) oself;
+
+        if (PyIndex_Check(item)) {
+                Py_ssize_t i;
+                PyObject *ret;
+
+                if (PyLong_CheckExact(item)) {
+                        i = PyInt_AsSsize_t(item);
+                        if (i == -1 && PyErr_Occurred()) {
+                                PyErr_Clear();
+                                goto number;
+                        }
+                } else {
+                number:
+                        i = PyNumber_AsSsize_t(item, PyExc_IndexError);
+                        if (i == -1 && PyErr_Occurred())
+                                return _ob(NULL);
+                }
+
+                if (i < 0)
+                        i += self->n;
+
+                if (i < 0 || i >= self->n) {
+                        set_index_error();
+                        return _ob(NULL);
+                }
 
-        invariants(self, VALID_USER | VALID_DECREF);
+                if (self->leaf)
+                        ret = self->children[i];
+                else
+                        ret = _PyBList_GET_ITEM_FAST2((PyBListRoot*)self, i);
+                Py_INCREF(ret);
 
-        fast_cmp_type = check_fast_cmp_type(v, Py_EQ);
+                return _ob(ret);
+        } else if (PySlice_Check(item)) {
+                Py_ssize_t start, stop, step, slicelength, cur, i;
+                PyBList* result;
+                PyObject* it;
 
-        ITER(self, item, {
-                c = fast_eq(item, v, fast_cmp_type);
-                if (c > 0)
-                        count++;
-                else if (c < 0) {
-                        ITER_CLEANUP();
-                        decref_flush();
+#if PY_MAJOR_VERSION < 3 || PY_MAJOR_VERSION == 3 && PY_MINOR_VERSION < 2
+                if (PySlice_GetIndicesEx((PySliceObject*)item, self->n,
+#else
+                if (PySlice_GetIndicesEx(item, self->n,
+#endif
+                                         &start, &stop,&step,&slicelength)<0) {
                         return _ob(NULL);
                 }
-        })
 
-        decref_flush();
-        return _ob(PyInt_FromSsize_t(count));
-}
+                if (step == 1)
+                        return _redir((PyObject *)
+                                      py_blist_get_slice((PyObject *) self, start, stop));
 
-BLIST_PYAPI(PyObject *)
-py_blist_index(PyBList *self, PyObject *args)
-{
-        Py_ssize_t i, start=0, stop=self->n;
-        PyObject *v;
-        int c, err;
-        PyObject *item;
-        fast_compare_data_t fast_cmp_type;
+                result = blist_root_new();
 
-        invariants(self, VALID_USER|VALID_DECREF);
+                if (slicelength <= 0)
+                        return _ob((PyObject *) result);
 
-        DANGER_BEGIN;
-        err = PyArg_ParseTuple(args, "O|O&O&:index", &v,
-                               _PyEval_SliceIndex, &start,
-                               _PyEval_SliceIndex, &stop);
-        DANGER_END;
-        if (!err)
-                return _ob(NULL);
-        if (start < 0) {
-                start += self->n;
-                if (start < 0)
-                        start = 0;
-        } else if (start > self->n)
-                start = self->n;
-        if (stop < 0) {
-                stop += self->n;
-                if (stop < 0)
-                        stop = 0;
-        } else if (stop > self->n)
-                stop = self->n;
+                /* This could be made slightly faster by using forests */
+                /* Also, by special-casing small trees */
+                for (cur = start, i = 0; i < slicelength; cur += step, i++) {
+                        int err;
 
-        fast_cmp_type = check_fast_cmp_type(v, Py_EQ);
-        i = start;
-        ITER2(self, item, start, stop, {
-                c = fast_eq(item, v, fast_cmp_type);
-                if (c > 0) {
-                        ITER_CLEANUP();
-                        decref_flush();
-                        return _ob(PyInt_FromSsize_t(i));
-                } else if (c < 0) {
-                        ITER_CLEANUP();
-                        decref_flush();
-                        return _ob(NULL);
+                        it = blist_get1(self, cur);
+                        err = blist_append(result, it);
+                        if (err < 0) {
+                                Py_DECREF(result);
+                                return _ob(NULL);
+                        }
                 }
-                i++;
-        })
 
-        decref_flush();
-        PyErr_SetString(PyExc_ValueError, "list.index(x): x not in list");
-        return _ob(NULL);
+                ext_mark(result, 0, DIRTY);
+                return _ob((PyObject *) result);
+        } else {
+                PyErr_SetString(PyExc_TypeError,
+                                "list indices must be integers");
+                return _ob(NULL);
+        }
 }
 
-BLIST_PYAPI(PyObject *)
-py_blist_remove(PyBList *self, PyObject *v)
+#if PY_MAJOR_VERSION == 2 && PY_MINOR_VERSION >= 6 || PY_MAJOR_VERSION >= 3
+static PyObject *
+py_blist_root_sizeof(PyBListRoot *root)
 {
-        Py_ssize_t i;
-        int c;
-        PyObject *item;
-        fast_compare_data_t fast_cmp_type;
-
-        invariants(self, VALID_USER|VALID_RW|VALID_DECREF);
-
-        fast_cmp_type = check_fast_cmp_type(v, Py_EQ);
-        i = 0;
-        ITER(self, item, {
-                c = fast_eq(item, v, fast_cmp_type);
-                if (c > 0) {
-                        ITER_CLEANUP();
-                        blist_delitem(self, i);
-                        decref_flush();
-                        ext_mark(self, 0, DIRTY);
-                        Py_RETURN_NONE;
-                } else if (c < 0) {
-                        ITER_CLEANUP();
-                        decref_flush();
-                        return _ob(NULL);
-                }
-                i++;
-        })
-
-        decref_flush();
-        PyErr_SetString(PyExc_ValueError, "list.remove(x): x not in list");
-        return _ob(NULL);
+        Py_ssize_t res;
+        res = sizeof(PyBListRoot)
+                + root->allocated * sizeof(PyObject *)
+                + root->index_allocated * (sizeof (PyBList *) +sizeof(Py_ssize_t))
+                + root->dirty_length * sizeof(Py_ssize_t)
+                + (root->index_allocated ?
+                   SETCLEAN_LEN(root->index_allocated) * sizeof(unsigned): 0)
+                + root->sizes_allocated * sizeof(Py_ssize_t);
+        return PyLong_FromSsize_t(res);
 }
 
-BLIST_PYAPI(PyObject *)
-py_blist_pop(PyBList *self, PyObject *args)
+static PyObject *
+py_blist_sizeof(PyBList *self)
 {
-        Py_ssize_t i = -1;
-        PyObject *v;
-        int err;
+        Py_ssize_t res;
+        res = sizeof(PyBList)
+                + LIMIT * sizeof(PyObject *)
+                + self->sizes_allocated * sizeof(Py_ssize_t);
+        return PyLong_FromSsize_t(res);
+}
 
-        invariants(self, VALID_USER|VALID_RW|VALID_DECREF);
+PyDoc_STRVAR(sizeof_doc,
+"L.__sizeof__() -- size of L in memory, in bytes");
+#endif
 
-        DANGER_BEGIN;
-        err = PyArg_ParseTuple(args, "|n:pop", &i);
-        DANGER_END;
-        if (!err)
-                return _ob(NULL);
+/************************************************************************
+ * BList cursor
+ *
+ * A cursor is a position in a root, along with the path from the root
+ * to the leaf holding that position.  Moving by a few items and
+ * editing at the cursor then only touch that leaf and its ancestors,
+ * instead of locating the position from the root every time.
+ *
+ * The path is made of borrowed references, so it is only trusted while
+ * root->generation is unchanged: any operation that may move or free
+ * nodes dirties or rebuilds the index, which advances the generation.
+ * Appending and popping at the end only change counts along the right
+ * spine, so the cursor still checks that its position is in its leaf.
+ */
 
-        if (self->n == 0) {
-                /* Special-case most common failure cause */
-                PyErr_SetString(PyExc_IndexError, "pop from empty list");
-                return _ob(NULL);
-        }
+typedef struct {
+        PyObject_HEAD
+        PyBListRoot *root;
+        Py_ssize_t i;                   /* Position; may exceed root->n */
+        Py_ssize_t generation;          /* root->generation of the path */
+        int depth;                      /* # of internal nodes, or -1 */
+        point_t stack[MAX_HEIGHT];      /* Internal nodes and child taken */
+        Py_ssize_t offsets[MAX_HEIGHT]; /* Position of each node's first item */
+        PyBList *leaf;
+        Py_ssize_t offset;              /* Position of leaf's first item */
+} blistcursorobject;
 
-        if (i == -1 || i == self->n-1) {
-                v = blist_pop_last_fast(self);
-                if (v)
-                        return _ob(v);
+/* Find the path to the leaf holding the cursor's position, or to the
+ * last leaf if the cursor is at the end.  Climbs only as far as the
+ * nearest ancestor holding the position, so nearby moves cost O(1)
+ * amortized.
+ */
+BLIST_LOCAL(void)
+cursor_locate(blistcursorobject *c)
+{
+        PyBListRoot *root = c->root;
+        Py_ssize_t i = c->i;
+        Py_ssize_t offset;
+        PyBList *p;
+        int d = 0;
+
+        assert(!root->leaf);
+        assert(i <= root->n);
+
+        if (c->depth >= 0 && c->generation == root->generation) {
+                Py_ssize_t k = i - c->offset;
+                if (k >= 0 && (k < c->leaf->num_children
+                               || (k == c->leaf->num_children
+                                   && i == root->n)))
+                        return;
+                for (d = c->depth - 1; d > 0; d--) {
+                        p = c->stack[d].lst;
+                        if (i >= c->offsets[d] && i < c->offsets[d] + p->n)
+                                break;
+                }
         }
 
-        if (i < 0)
-                i += self->n;
-        if (i < 0 || i >= self->n) {
-                PyErr_SetString(PyExc_IndexError, "pop index out of range");
-                return _ob(NULL);
+        if (d == 0) {
+                p = (PyBList *) root;
+                offset = 0;
+        } else {
+                p = c->stack[d].lst;
+                offset = c->offsets[d];
         }
 
-        v = blist_delitem_return(self, i);
-        ext_mark(self, 0, DIRTY);
+        while (!p->leaf) {
+                PyObject *child;
+                Py_ssize_t so_far;
+                int k;
 
-        decref_flush(); /* Remove any deleted BList nodes */
+                blist_locate(p, i - offset, &child, &k, &so_far);
+                c->stack[d].lst = p;
+                c->stack[d].i = k;
+                c->offsets[d++] = offset;
+                offset += so_far;
+                p = (PyBList *) child;
+        }
 
-        return _ob(v); /* the caller now owns the reference the list had */
+        c->depth = d;
+        c->leaf = p;
+        c->offset = offset;
+        c->generation = root->generation;
 }
 
-BLIST_PYAPI(PyObject *)
-py_blist_clear(PyBList *self)
+/* Return true if no node below the root on the cursor's path is shared,
+ * so that the leaf may be changed in place */
+BLIST_LOCAL_INLINE(int)
+cursor_rw(blistcursorobject *c)
 {
-        invariants(self, VALID_USER|VALID_RW|VALID_DECREF);
-
-        blist_forget_children(self);
-        self->n = 0;
-        self->leaf = 1;
-        ext_dealloc((PyBListRoot *) self);
+        int d;
 
-        decref_flush();
-        Py_RETURN_NONE;
+        if (Py_REFCNT(c->leaf) > 1)
+                return 0;
+        for (d = 1; d < c->depth; d++)
+                if (Py_REFCNT(c->stack[d].lst) > 1)
+                        return 0;
+        return 1;
 }
 
-BLIST_PYAPI(PyObject *)
-py_blist_copy(PyBList *self)
+/* Add delta to the size of every internal node on the cursor's path */
+BLIST_LOCAL_INLINE(void)
+cursor_adjust_n(blistcursorobject *c, int delta)
 {
-        invariants(self, VALID_USER);
-        return (PyObject *) _blist(blist_root_copy(self));
+        int d;
+
+        for (d = 0; d < c->depth; d++) {
+                PyBList *p = c->stack[d].lst;
+                p->n += delta;
+                if (p->sizes_valid)
+                        p->sizes[c->stack[d].i] += delta;
+        }
 }
 
+/* The list may have shrunk beneath the cursor */
+#define CURSOR_CLAMP(c) do { if ((c)->i > (c)->root->n) \
+                                (c)->i = (c)->root->n; } while (0)
+
 BLIST_PYAPI(PyObject *)
-py_blist_insert(PyBList *self, PyObject *args)
+py_blist_cursor(PyBListRoot *self, PyObject *args)
 {
-        Py_ssize_t i;
-        PyObject *v;
-        PyBList *overflow;
+        Py_ssize_t i = 0;
+        blistcursorobject *c;
         int err;
 
-        invariants(self, VALID_USER|VALID_RW);
+        invariants(self, VALID_USER);
 
         DANGER_BEGIN;
-        err = PyArg_ParseTuple(args, "nO:insert", &i, &v);
+        err = PyArg_ParseTuple(args, "|n:cursor", &i);
         DANGER_END;
         if (!err)
                 return _ob(NULL);
 
-        if (self->n == PY_SSIZE_T_MAX) {
-                PyErr_SetString(PyExc_OverflowError,
-                                "cannot add more objects to list");
+        if (i < 0)
+                i += self->n;
+        if (i < 0 || i > self->n) {
+                set_index_error();
                 return _ob(NULL);
         }
 
-        if (i < 0) {
-                i += self->n;
-                if (i < 0)
-                        i = 0;
-        } else if (i > self->n)
-                i = self->n;
+        DANGER_BEGIN;
+        c = PyObject_GC_New(blistcursorobject, &PyBListCursor_Type);
+        DANGER_END;
+        if (c == NULL)
+                return _ob(NULL);
 
-        /* Speed up the common case */
-        if (self->leaf && self->num_children < LIMIT) {
-                Py_INCREF(v);
+        Py_INCREF(self);
+        c->root = self;
+        c->i = i;
+        c->depth = -1;
 
-                shift_right(self, i, 1);
-                self->num_children++;
-                self->n++;
-                self->children[i] = v;
-                Py_RETURN_NONE;
-        }
+        PyObject_GC_Track(c);
+        return _ob((PyObject *) c);
+}
+
+static void blistcursor_dealloc(PyObject *oc)
+{
+        blistcursorobject *c = (blistcursorobject *) oc;
+
+        PyObject_GC_UnTrack(c);
+        decref_later((PyObject *) c->root);
+        PyObject_GC_Del(c);
+        _decref_flush();
+}
 
-        overflow = ins1(self, i, v);
-        if (overflow)
-                blist_overflow_root(self, overflow);
-        ext_mark(self, 0, DIRTY);
-        Py_RETURN_NONE;
+static int blistcursor_traverse(PyObject *oc, visitproc visit, void *arg)
+{
+        blistcursorobject *c = (blistcursorobject *) oc;
+
+        Py_VISIT(c->root);
+        return 0;
 }
 
-BLIST_PYAPI(PyObject *)
-py_blist_append(PyBList *self, PyObject *v)
+static PyObject *blistcursor_get_index(blistcursorobject *c, void *closure)
 {
-        int err;
+        CURSOR_CLAMP(c);
+        return PyInt_FromSsize_t(c->i);
+}
 
-        invariants(self, VALID_USER|VALID_RW);
+static PyObject *blistcursor_next(blistcursorobject *c)
+{
+        CURSOR_CLAMP(c);
+        if (c->i == c->root->n) {
+                PyErr_SetString(PyExc_IndexError, "cursor at end of list");
+                return NULL;
+        }
+        c->i++;
+        Py_RETURN_NONE;
+}
 
-        err = blist_append(self, v);
+static PyObject *blistcursor_prev(blistcursorobject *c)
+{
+        CURSOR_CLAMP(c);
+        if (c->i == 0) {
+                PyErr_SetString(PyExc_IndexError, "cursor at start of list");
+                return NULL;
+        }
+        c->i--;
+        Py_RETURN_NONE;
+}
 
-        if (err < 0)
-                return _ob(NULL);
+static PyObject *blistcursor_seek(blistcursorobject *c, PyObject *args)
+{
+        Py_ssize_t i;
 
+        if (!PyArg_ParseTuple(args, "n:seek", &i))
+                return NULL;
+        if (i < 0)
+                i += c->root->n;
+        if (i < 0 || i > c->root->n) {
+                set_index_error();
+                return NULL;
+        }
+        c->i = i;
         Py_RETURN_NONE;
 }
 
-BLIST_PYAPI(PyObject *)
-py_blist_subscript(PyObject *oself, PyObject *item)
+static PyObject *blistcursor_get(blistcursorobject *c)
 {
-        PyBList *self;
+        PyBListRoot *root = c->root;
+        PyObject *rv;
 
-        invariants(oself, VALID_USER);
+        CURSOR_CLAMP(c);
+        if (c->i == root->n) {
+                set_index_error();
+                return NULL;
+        }
 
-        self = (PyBList *) oself;
+        if (root->leaf)
+                rv = root->children[c->i];
+        else {
+                cursor_locate(c);
+                rv = c->leaf->children[c->i - c->offset];
+        }
+        Py_INCREF(rv);
+        return rv;
+}
 
-        if (PyIndex_Check(item)) {
-                Py_ssize_t i;
-                PyObject *ret;
+static PyObject *blistcursor_set(blistcursorobject *c, PyObject *v)
+{
+        PyBListRoot *root = c->root;
+        PyObject *old_value;
 
-                if (PyLong_CheckExact(item)) {
-                        i = PyInt_AsSsize_t(item);
-                        if (i == -1 && PyErr_Occurred()) {
-                                PyErr_Clear();
-                                goto number;
-                        }
-                } else {
-                number:
-                        i = PyNumber_AsSsize_t(item, PyExc_IndexError);
-                        if (i == -1 && PyErr_Occurred())
-                                return _ob(NULL);
-                }
+        CURSOR_CLAMP(c);
+        if (c->i == root->n) {
+                set_index_error();
+                return NULL;
+        }
 
-                if (i < 0)
-                        i += self->n;
+        sorted_prefix_cut((PyBList *) root, c->i);
 
-                if (i < 0 || i >= self->n) {
-                        set_index_error();
-                        return _ob(NULL);
+        if (!root->leaf) {
+                cursor_locate(c);
+                if (cursor_rw(c)) {
+                        PyObject **slot = &c->leaf->children[c->i - c->offset];
+                        old_value = *slot;
+                        Py_INCREF(v);
+                        *slot = v;
+                        Py_DECREF(old_value);
+                        Py_RETURN_NONE;
                 }
+        }
 
-                if (self->leaf)
-                        ret = self->children[i];
-                else
-                        ret = _PyBList_GET_ITEM_FAST2((PyBListRoot*)self, i);
-                Py_INCREF(ret);
+        old_value = blist_ass_item_return((PyBList *) root, c->i, v);
+        Py_XDECREF(old_value);
+        Py_RETURN_NONE;
+}
 
-                return _ob(ret);
-        } else if (PySlice_Check(item)) {
-                Py_ssize_t start, stop, step, slicelength, cur, i;
-                PyBList* result;
-                PyObject* it;
+static PyObject *blistcursor_insert(blistcursorobject *c, PyObject *v)
+{
+        PyBListRoot *root = c->root;
+        Py_ssize_t i;
 
-#if PY_MAJOR_VERSION < 3 || PY_MAJOR_VERSION == 3 && PY_MINOR_VERSION < 2
-                if (PySlice_GetIndicesEx((PySliceObject*)item, self->n,
-#else
-                if (PySlice_GetIndicesEx(item, self->n,
-#endif
-                                         &start, &stop,&step,&slicelength)<0) {
-                        return _ob(NULL);
+        CURSOR_CLAMP(c);
+        i = c->i;
+        if (root->n == PY_SSIZE_T_MAX) {
+                PyErr_SetString(PyExc_OverflowError,
+                                "cannot add more objects to list");
+                return NULL;
+        }
+
+        sorted_prefix_cut((PyBList *) root, i);
+
+        if (!root->leaf) {
+                cursor_locate(c);
+                if (c->leaf->num_children < LIMIT && cursor_rw(c)) {
+                        PyBList *leaf = c->leaf;
+                        Py_ssize_t old_n = root->n;
+                        int k = i - c->offset;
+
+                        cursor_adjust_n(c, 1);
+                        shift_right(leaf, k, 1);
+                        leaf->children[k] = v;
+                        leaf->num_children++;
+                        leaf->n++;
+                        Py_INCREF(v);
+                        ext_mark_moved((PyBList *) root, i, old_n);
+                        c->generation = root->generation;
+                        c->i++;
+                        Py_RETURN_NONE;
                 }
+        }
 
-                if (step == 1)
-                        return _redir((PyObject *)
-                                      py_blist_get_slice((PyObject *) self, start, stop));
+        if (blist_insert_root((PyBList *) root, i, v) < 0)
+                return NULL;
+        c->depth = -1;
+        c->i++;
+        Py_RETURN_NONE;
+}
 
-                result = blist_root_new();
+static PyObject *blistcursor_delete(blistcursorobject *c)
+{
+        PyBListRoot *root = c->root;
+        Py_ssize_t i;
 
-                if (slicelength <= 0)
-                        return _ob((PyObject *) result);
+        CURSOR_CLAMP(c);
+        i = c->i;
+        if (i == root->n) {
+                set_index_error();
+                return NULL;
+        }
 
-                /* This could be made slightly faster by using forests */
-                /* Also, by special-casing small trees */
-                for (cur = start, i = 0; i < slicelength; cur += step, i++) {
-                        int err;
+        sorted_prefix_cut((PyBList *) root, i);
 
-                        it = blist_get1(self, cur);
-                        err = blist_append(result, it);
-                        if (err < 0) {
-                                Py_DECREF(result);
-                                return _ob(NULL);
-                        }
-                }
+        if (!root->leaf) {
+                cursor_locate(c);
+                if (c->leaf->num_children > HALF && cursor_rw(c)) {
+                        PyBList *leaf = c->leaf;
+                        Py_ssize_t old_n = root->n;
+                        int k = i - c->offset;
 
-                ext_mark(result, 0, DIRTY);
-                return _ob((PyObject *) result);
-        } else {
-                PyErr_SetString(PyExc_TypeError,
-                                "list indices must be integers");
-                return _ob(NULL);
+                        decref_later(leaf->children[k]);
+                        shift_left(leaf, k + 1, 1);
+                        leaf->num_children--;
+                        leaf->n--;
+                        cursor_adjust_n(c, -1);
+                        ext_mark_moved((PyBList *) root, i, old_n);
+                        c->generation = root->generation;
+                        decref_flush();
+                        Py_RETURN_NONE;
+                }
         }
-}
 
-#if PY_MAJOR_VERSION == 2 && PY_MINOR_VERSION >= 6 || PY_MAJOR_VERSION >= 3
-static PyObject *
-py_blist_root_sizeof(PyBListRoot *root)
-{
-        Py_ssize_t res;
-        res = sizeof(PyBListRoot)
-                + LIMIT * sizeof(PyObject *)
-                + root->index_allocated * (sizeof (PyBList *) +sizeof(Py_ssize_t))
-                + root->dirty_length * sizeof(Py_ssize_t)
-                + (root->index_allocated ?
-                   SETCLEAN_LEN(root->index_allocated) * sizeof(unsigned): 0);
-        return PyLong_FromSsize_t(res);
+        blist_delitem((PyBList *) root, i);
+        ext_mark_moved((PyBList *) root, i, root->n + 1);
+        c->depth = -1;
+        decref_flush();
+        Py_RETURN_NONE;
 }
 
-static PyObject *
-py_blist_sizeof(PyBList *self)
-{
-        Py_ssize_t res;
-        res = sizeof(PyBList)
-                + LIMIT * sizeof(PyObject *);
-        return PyLong_FromSsize_t(res);
-}
+PyDoc_STRVAR(cursor_next_doc,
+"C.next() -- move to the next position");
+PyDoc_STRVAR(cursor_prev_doc,
+"C.prev() -- move to the previous position");
+PyDoc_STRVAR(cursor_seek_doc,
+"C.seek(index) -- move to index");
+PyDoc_STRVAR(cursor_get_doc,
+"C.get() -> item -- the item at the cursor");
+PyDoc_STRVAR(cursor_set_doc,
+"C.set(object) -- replace the item at the cursor");
+PyDoc_STRVAR(cursor_insert_doc,
+"C.insert(object) -- insert object before the cursor and move past it");
+PyDoc_STRVAR(cursor_delete_doc,
+"C.delete() -- remove the item at the cursor");
+
+static PyMethodDef blistcursor_methods[] = {
+        {"next",   (PyCFunction)blistcursor_next,   METH_NOARGS, cursor_next_doc},
+        {"prev",   (PyCFunction)blistcursor_prev,   METH_NOARGS, cursor_prev_doc},
+        {"seek",   (PyCFunction)blistcursor_seek,   METH_VARARGS, cursor_seek_doc},
+        {"get",    (PyCFunction)blistcursor_get,    METH_NOARGS, cursor_get_doc},
+        {"set",    (PyCFunction)blistcursor_set,    METH_O, cursor_set_doc},
+        {"insert", (PyCFunction)blistcursor_insert, METH_O, cursor_insert_doc},
+        {"delete", (PyCFunction)blistcursor_delete, METH_NOARGS, cursor_delete_doc},
+        {NULL,          NULL}           /* sentinel */
+};
 
-PyDoc_STRVAR(sizeof_doc,
-"L.__sizeof__() -- size of L in memory, in bytes");
-#endif
+static PyGetSetDef blistcursor_getset[] = {
+        {"index", (getter)blistcursor_get_index, NULL,
+         "the cursor's position in the list", NULL},
+        {NULL}                          /* sentinel */
+};
+
+PyTypeObject PyBListCursor_Type = {
+        PyVarObject_HEAD_INIT(NULL, 0)
+        "blistcursor",                          /* tp_name */
+        sizeof(blistcursorobject),              /* tp_basicsize */
+        0,                                      /* tp_itemsize */
+        /* methods */
+        blistcursor_dealloc,                    /* tp_dealloc */
+        0,                                      /* tp_print */
+        0,                                      /* tp_getattr */
+        0,                                      /* tp_setattr */
+        0,                                      /* tp_compare */
+        0,                                      /* tp_repr */
+        0,                                      /* tp_as_number */
+        0,                                      /* tp_as_sequence */
+        0,                                      /* tp_as_mapping */
+        0,                                      /* tp_hash */
+        0,                                      /* tp_call */
+        0,                                      /* tp_str */
+        PyObject_GenericGetAttr,                /* tp_getattro */
+        0,                                      /* tp_setattro */
+        0,                                      /* tp_as_buffer */
+        Py_TPFLAGS_DEFAULT | Py_TPFLAGS_HAVE_GC,/* tp_flags */
+        0,                                      /* tp_doc */
+        blistcursor_traverse,                   /* tp_traverse */
+        0,                                      /* tp_clear */
+        0,                                      /* tp_richcompare */
+        0,                                      /* tp_weaklistoffset */
+        0,                                      /* tp_iter */
+        0,                                      /* tp_iternext */
+        blistcursor_methods,                    /* tp_methods */
+        0,                                      /* tp_members */
+        blistcursor_getset,                     /* tp_getset */
+};
 
 /************************************************************************
  * Routines for supporting pickling
@@ -7059,6 +10672,9 @@ py_blist_setstate(PyBList *self, PyObject *state)
                 return _ob(NULL);
         }
 
+        if (blist_root_reserve(self, LIMIT) < 0)
+                return _ob(NULL);
+
         for (self->n = i = 0; i < PyList_GET_SIZE(state); i++) {
                 PyObject *child = PyList_GET_ITEM(state, i);
                 if (Py_TYPE(child) == &PyBList_Type) {
@@ -7103,6 +10719,24 @@ PyDoc_STRVAR(reversed_doc,
              "L.__reversed__() -- return a reverse iterator over the list");
 PyDoc_STRVAR(append_doc,
 "L.append(object) -- append object to end");
+PyDoc_STRVAR(appendleft_doc,
+"L.appendleft(object) -- insert object at the beginning");
+PyDoc_STRVAR(extendleft_doc,
+"L.extendleft(iterable) -- insert each element from the iterable at the\n\
+beginning, reversing their order");
+PyDoc_STRVAR(popleft_doc,
+"L.popleft() -> item -- remove and return the first item");
+PyDoc_STRVAR(rotate_doc,
+"L.rotate(k=1) -- move the last k items to the beginning (the first -k\n\
+items to the end if k is negative)");
+PyDoc_STRVAR(move_doc,
+"L.move(start, stop, dest) -- move L[start:stop] to just before index dest");
+PyDoc_STRVAR(partition_chunks_doc,
+"L.partition_chunks(k) -> tuple of k blists of roughly equal length");
+PyDoc_STRVAR(iter_chunks_doc,
+"L.iter_chunks() -> iterator over the items of L in tuples, one per leaf");
+PyDoc_STRVAR(split_doc,
+"L.split(index) -> (blist, blist) -- L[:index] and L[index:]");
 PyDoc_STRVAR(extend_doc,
 "L.extend(iterable) -- extend list by appending elements from the iterable");
 PyDoc_STRVAR(insert_doc,
@@ -7120,6 +10754,35 @@ PyDoc_STRVAR(reverse_doc,
 PyDoc_STRVAR(sort_doc,
 "L.sort(cmp=None, key=None, reverse=False) -- stable sort *IN PLACE*;\n\
 cmp(x, y) -> -1, 0, 1");
+PyDoc_STRVAR(argsort_doc,
+"L.argsort(key=None, reverse=False) -> list -- indices of L in stable\n\
+sorted order");
+PyDoc_STRVAR(nsmallest_doc,
+"L.nsmallest(k, key=None) -> list -- the k smallest items of L, in stable\n\
+sorted order");
+PyDoc_STRVAR(nlargest_doc,
+"L.nlargest(k, key=None) -> list -- the k largest items of L, in stable\n\
+reverse sorted order");
+PyDoc_STRVAR(select_doc,
+"L.select(k, key=None) -> item -- the item a stable sort would put at\n\
+index k");
+PyDoc_STRVAR(bisect_left_doc,
+"L._bisect_left(key, [keyed]) -> integer -- locate the leftmost insertion\n\
+point for key in sorted L; if keyed, L holds (key, value) pairs");
+PyDoc_STRVAR(bisect_right_doc,
+"L._bisect_right(key, [keyed]) -> integer -- locate the rightmost insertion\n\
+point for key in sorted L; if keyed, L holds (key, value) pairs");
+PyDoc_STRVAR(insort_doc,
+"L._insort(item, [keyed]) -> integer -- insert item into sorted L, after any\n\
+equal items, and return its index");
+PyDoc_STRVAR(set_index_policy_doc,
+"L.set_index_policy(build, drop) -> (build, drop) -- index L for reads by\n\
+position only after build reads have missed the index (-1: never), and\n\
+free the index after drop modifications or iterations without such a\n\
+read (0: never); returns the previous policy");
+PyDoc_STRVAR(cursor_doc,
+"L.cursor([index]) -> cursor -- a cursor at index (default 0), for moving\n\
+and editing near a position without locating it from the root each time");
 PyDoc_STRVAR(clear_doc,
 "L.clear() -> None -- remove all items from L");
 PyDoc_STRVAR(copy_doc,
@@ -7137,6 +10800,14 @@ static PyMethodDef blist_methods[] = {
         {"extend",      (PyCFunction)py_blist_extend,  METH_O, extend_doc},
         {"pop",         (PyCFunction)py_blist_pop,     METH_VARARGS, pop_doc},
         {"remove",      (PyCFunction)py_blist_remove,  METH_O, remove_doc},
+        {"appendleft",  (PyCFunction)py_blist_appendleft, METH_O, appendleft_doc},
+        {"extendleft",  (PyCFunction)py_blist_extendleft, METH_O, extendleft_doc},
+        {"popleft",     (PyCFunction)py_blist_popleft, METH_NOARGS, popleft_doc},
+        {"rotate",      (PyCFunction)py_blist_rotate,  METH_VARARGS, rotate_doc},
+        {"move",        (PyCFunction)py_blist_move,    METH_VARARGS, move_doc},
+        {"split",       (PyCFunction)py_blist_split,   METH_VARARGS, split_doc},
+        {"partition_chunks", (PyCFunction)py_blist_partition_chunks, METH_VARARGS, partition_chunks_doc},
+        {"iter_chunks", (PyCFunction)py_blist_iter_chunks, METH_NOARGS, iter_chunks_doc},
         {"index",       (PyCFunction)py_blist_index,   METH_VARARGS, index_doc},
         {"clear",       (PyCFunction)py_blist_clear,   METH_NOARGS, clear_doc},
         {"copy",       (PyCFunction)py_blist_copy,   METH_NOARGS, copy_doc},
@@ -7144,6 +10815,15 @@ static PyMethodDef blist_methods[] = {
         {"count",       (PyCFunction)py_blist_count,   METH_O, count_doc},
         {"reverse",     (PyCFunction)py_blist_reverse, METH_NOARGS, reverse_doc},
         {"sort",        (PyCFunction)py_blist_sort,    METH_VARARGS | METH_KEYWORDS, sort_doc},
+        {"argsort",     (PyCFunction)py_blist_argsort, METH_VARARGS | METH_KEYWORDS, argsort_doc},
+        {"nsmallest",   (PyCFunction)py_blist_nsmallest, METH_VARARGS | METH_KEYWORDS, nsmallest_doc},
+        {"nlargest",    (PyCFunction)py_blist_nlargest, METH_VARARGS | METH_KEYWORDS, nlargest_doc},
+        {"select",      (PyCFunction)py_blist_select, METH_VARARGS | METH_KEYWORDS, select_doc},
+        {"_bisect_left", (PyCFunction)py_blist_bisect_left, METH_VARARGS, bisect_left_doc},
+        {"_bisect_right", (PyCFunction)py_blist_bisect_right, METH_VARARGS, bisect_right_doc},
+        {"_insort",     (PyCFunction)py_blist_insort,  METH_VARARGS, insort_doc},
+        {"set_index_policy", (PyCFunction)py_blist_set_index_policy, METH_VARARGS | METH_KEYWORDS, set_index_policy_doc},
+        {"cursor",      (PyCFunction)py_blist_cursor,  METH_VARARGS, cursor_doc},
 #if defined(Py_DEBUG) && !defined(BLIST_IN_PYTHON)
         {"debug",       (PyCFunction)py_blist_debug,   METH_NOARGS, NULL},
 #endif
@@ -7276,7 +10956,7 @@ PyTypeObject PyBList_Type = {
 #else
         "blist._blist.__internal_blist",
 #endif
-        sizeof(PyBList),
+        sizeof(PyBList) + LIMIT * sizeof(PyObject *),
         0,
         py_blist_dealloc,                       /* tp_dealloc */
         0,                                      /* tp_print */
@@ -7367,7 +11047,129 @@ PyTypeObject PyRootBList_Type = {
         PyObject_GC_Del,                        /* tp_free */
 };
 
-static PyMethodDef module_methods[] = { { NULL } };
+/************************************************************************
+ * Module functions
+ */
+
+/* Free cached nodes until at most max internal nodes remain */
+static void free_lists_trim(int max)
+{
+        PyBList *self;
+
+        while (num_free_lists > max) {
+                self = free_lists[--num_free_lists];
+                PyMem_Free(self->sizes);
+                PyObject_GC_Del(self);
+        }
+}
+
+BLIST_PYAPI(PyObject *)
+py_blist_release_memory(PyObject *module)
+{
+        PyBList *self;
+
+        free_lists_trim(0);
+        PyMem_Free(free_lists);
+        free_lists = NULL;
+        allocated_free_lists = 0;
+
+        while (num_free_ulists) {
+                self = free_ulists[--num_free_ulists];
+                root_children_free((PyBListRoot *) self);
+                PyMem_Free(self->sizes);
+                PyObject_GC_Del(self);
+        }
+        while (num_free_iters)
+                PyObject_GC_Del(free_iters[--num_free_iters]);
+        while (num_free_forests)
+                PyMem_Free(forest_saved[--num_free_forests]);
+
+        slabs_trim(0);
+
+        Py_RETURN_NONE;
+}
+
+BLIST_PYAPI(PyObject *)
+py_blist_set_cache_limits(PyObject *module, PyObject *args, PyObject *kwds)
+{
+        static char *kwlist[] = {"nodes", "slabs", 0};
+        int nodes = max_free_lists, slabs = max_free_slabs;
+        PyObject *rv;
+
+        rv = Py_BuildValue("(ii)", max_free_lists, max_free_slabs);
+        if (rv == NULL)
+                return NULL;
+        if (!PyArg_ParseTupleAndKeywords(args, kwds, "|ii:set_cache_limits",
+                                         kwlist, &nodes, &slabs)) {
+                Py_DECREF(rv);
+                return NULL;
+        }
+        if (nodes < 0 || slabs < 0) {
+                Py_DECREF(rv);
+                PyErr_SetString(PyExc_ValueError,
+                                "cache limits must be non-negative");
+                return NULL;
+        }
+
+        max_free_lists = nodes;
+        free_lists_trim(nodes);
+        max_free_slabs = slabs;
+        slabs_trim(slabs);
+
+        return rv;
+}
+
+static PyObject *
+py_blist_set_parallel_sort_threshold(PyObject *module, PyObject *args)
+{
+        Py_ssize_t n, old = parallel_sort_threshold;
+
+        if (!PyArg_ParseTuple(args, "n:_set_parallel_sort_threshold", &n))
+                return NULL;
+        if (n < 4) {
+                PyErr_SetString(PyExc_ValueError,
+                                "threshold must be at least 4");
+                return NULL;
+        }
+
+        parallel_sort_threshold = n;
+        return PyInt_FromSsize_t(old);
+}
+
+PyDoc_STRVAR(release_memory_doc,
+"release_memory() -- return the memory of cached, unused blist nodes to\n\
+the system");
+PyDoc_STRVAR(set_cache_limits_doc,
+"set_cache_limits(nodes, slabs) -> (nodes, slabs) -- set how many unused\n\
+nodes and unused slabs of node storage to keep for reuse; returns the\n\
+previous limits");
+PyDoc_STRVAR(set_parallel_sort_threshold_doc,
+"_set_parallel_sort_threshold(n) -> n -- sort lists of at least n items\n\
+with several threads; returns the previous threshold (for testing)");
+
+static PyMethodDef module_methods[] = {
+        {"release_memory", (PyCFunction)py_blist_release_memory, METH_NOARGS, release_memory_doc},
+        {"set_cache_limits", (PyCFunction)py_blist_set_cache_limits, METH_VARARGS | METH_KEYWORDS, set_cache_limits_doc},
+        {"_set_parallel_sort_threshold", (PyCFunction)py_blist_set_parallel_sort_threshold, METH_VARARGS, set_parallel_sort_threshold_doc},
+        { NULL }
+};
+
+static PyBList_CAPI blist_capi = {
+        &PyRootBList_Type,
+        _PyBList_GetChunk,
+};
+
+/* Make the C API available to other extension modules */
+BLIST_LOCAL(void)
+init_blist_capi(PyObject *m)
+{
+#if PY_VERSION_HEX >= 0x02070000
+        PyObject *capsule = PyCapsule_New(&blist_capi, PyBList_CAPSULE_NAME,
+                                          NULL);
+        if (capsule != NULL)
+                PyModule_AddObject(m, "_C_API", capsule);
+#endif
+}
 
 BLIST_LOCAL(int)
 init_blist_types1(void)
@@ -7379,11 +11181,15 @@ init_blist_types1(void)
         Py_TYPE(&PyRootBList_Type) = &PyType_Type;
         Py_TYPE(&PyBListIter_Type) = &PyType_Type;
         Py_TYPE(&PyBListReverseIter_Type) = &PyType_Type;
+        Py_TYPE(&PyBListChunkIter_Type) = &PyType_Type;
+        Py_TYPE(&PyBListCursor_Type) = &PyType_Type;
 
         Py_INCREF(&PyBList_Type);
         Py_INCREF(&PyRootBList_Type);
         Py_INCREF(&PyBListIter_Type);
         Py_INCREF(&PyBListReverseIter_Type);
+        Py_INCREF(&PyBListChunkIter_Type);
+        Py_INCREF(&PyBListCursor_Type);
 
         return 0;
 }
@@ -7395,6 +11201,8 @@ init_blist_types2(void)
         if (PyType_Ready(&PyBList_Type) < 0) return -1;
         if (PyType_Ready(&PyBListIter_Type) < 0) return -1;
         if (PyType_Ready(&PyBListReverseIter_Type) < 0) return -1;
+        if (PyType_Ready(&PyBListChunkIter_Type) < 0) return -1;
+        if (PyType_Ready(&PyBListCursor_Type) < 0) return -1;
 
         return 0;
 }
@@ -7420,6 +11228,7 @@ init_blist(void)
         PyModule_AddObject(m, "_limit", limit);
         PyModule_AddObject(m, "__internal_blist", (PyObject *)
                 &PyBList_Type);
+        init_blist_capi(m);
 
 #ifndef BLIST_IN_PYTHON
         gc_module = PyImport_ImportModule("gc");
@@ -7471,6 +11280,7 @@ PyInit__blist(void)
         PyModule_AddObject(m, "_limit", limit);
         PyModule_AddObject(m, "__internal_blist", (PyObject *)
                            &PyBList_Type);
+        init_blist_capi(m);
 
 #ifndef BLIST_IN_PYTHON
         gc_module = PyImport_ImportModule("gc");
@@ -7514,6 +11324,10 @@ PyObject *PyList_New(Py_ssize_t size)
 
         if (self == NULL)
                 return NULL;
+        if (blist_root_reserve(self, size ? size : 1) < 0) {
+                SAFE_DECREF(self);
+                return NULL;
+        }
 
         if (size <= LIMIT) {
                 self->n = size;
@@ -7612,6 +11426,9 @@ int PyList_Insert(PyObject *ob, Py_ssize_t i, PyObject *v)
                 i = self->n;
 
         if (self->leaf && self->num_children < LIMIT) {
+                if (blist_root_reserve(self, self->num_children + 1) < 0)
+                        return _int(-1);
+
                 Py_INCREF(v);
 
                 shift_right(self, i, 1);
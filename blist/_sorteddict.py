@@ -1,6 +1,10 @@
 from blist._sortedlist import sortedset, ReprRecursion
-import collections, sys
+import collections, itertools, sys
 from blist._blist import blist
+try: # pragma: no cover
+    izip = itertools.izip
+except AttributeError: # pragma: no cover
+    izip = zip
 
 class missingdict(dict):
     def __missing__(self, key):
@@ -27,14 +31,16 @@ class ItemsView(collections.ItemsView, collections.Sequence):
     def __getitem__(self, index):
         if isinstance(index, slice):
             keys = self._mapping._sortedkeys[index]
-            return self._from_iterable((key, self._mapping[key])
-                                       for key in keys)
+            values = self._mapping._value_at(index)
+            return self._from_iterable(izip(keys, values))
         key = self._mapping._sortedkeys[index]
-        return (key, self._mapping[key])
+        return (key, self._mapping._value_at(index))
+    def __iter__(self):
+        return izip(self._mapping._sortedkeys, self._mapping._itervalues())
     def index(self, item):
         key, value = item
-        i = self._mapping._sortedkeys.index(key)
-        if self._mapping[key] == value:
+        i = self._mapping._locate(key)
+        if i >= 0 and self._mapping._value_at(i) == value:
             return i
         raise ValueError
     def count(self, item):
@@ -49,18 +55,14 @@ class ItemsView(collections.ItemsView, collections.Sequence):
 class ValuesView(collections.ValuesView, collections.Sequence):
     def __getitem__(self, index):
         if isinstance(index, slice):
-            keys = self._mapping._sortedkeys[index]
-            return [self._mapping[key] for key in keys]
-        key = self._mapping._sortedkeys[index]
-        return self._mapping[key]
+            return list(self._mapping._value_at(index))
+        return self._mapping._value_at(index)
+    def __iter__(self):
+        return self._mapping._itervalues()
 
 class sorteddict(collections.MutableMapping):
     def __init__(self, *args, **kw):
-        if hasattr(self, '__missing__'):
-            self._map = missingdict()
-            self._map._missing = self.__missing__
-        else:
-            self._map = dict()
+        self._map = None
         key = None
         if len(args) > 0:
             if hasattr(args[0], '__call__'):
@@ -75,15 +77,73 @@ class sorteddict(collections.MutableMapping):
         if len(args) == 1 and isinstance(args[0], sorteddict) and key is None:
             key = args[0]._sortedkeys._key
         self._sortedkeys = sortedset(key=key)
+        self._values = blist()
         self.update(*args, **kw)
 
+    def _new_map(self):
+        if hasattr(self, '__missing__'):
+            m = missingdict()
+            m._missing = self.__missing__
+            return m
+        return dict()
+
+    def _get_hash_index(self):
+        return self._map is not None
+
+    def _set_hash_index(self, enabled):
+        if not enabled and self._map is not None:
+            self._values = blist(self._itervalues())
+            self._map = None
+        elif enabled and self._map is None:
+            m = self._new_map()
+            m.update(izip(self._sortedkeys, self._values))
+            self._map = m
+            self._values = None
+
+    hash_index = property(_get_hash_index, _set_hash_index, doc=
+        """Whether lookups by key use a hash table.
+
+        Without it, the values are kept in a blist alongside the sorted
+        keys, keys need not be hashable, and each entry uses less
+        memory, but looking up a key requires a search of the sorted
+        keys.  With it, the hash table holds the values instead.
+        """)
+
+    def _value_at(self, index):
+        "Return the value of the key at index (an int or a slice)"
+        if self._map is None:
+            return self._values[index]
+        if isinstance(index, slice):
+            return blist(self._map[key] for key in self._sortedkeys[index])
+        return self._map[self._sortedkeys[index]]
+
+    def _itervalues(self):
+        "Return an iterator over the values in key order"
+        if self._map is None:
+            return iter(self._values)
+        return (self._map[key] for key in self._sortedkeys)
+
+    def _locate(self, key):
+        "Return the position of key in the sorted keys, or -1 if absent"
+        if self._map is not None and key not in self._map:
+            return -1
+        keys = self._sortedkeys
+        try:
+            i = keys._blist._bisect_left(keys._u2key(key),
+                                         keys._key is not None)
+        except TypeError:
+            # key cannot be compared with the keys already present.
+            # Ergo, it isn't present.
+            return -1
+        return keys._advance(i, key)
+
     if sys.version_info[0] < 3:
         def keys(self):
             return self._sortedkeys.copy()
         def items(self):
-            return blist((key, self[key]) for key in self)
+            return blist(izip(self._sortedkeys, self._itervalues()))
         def values(self):
-            return blist(self[key] for key in self)
+            return blist(self._itervalues())
         def viewkeys(self):
             return KeysView(self)
         def viewitems(self):
@@ -99,21 +159,49 @@ class sorteddict(collections.MutableMapping):
             return ValuesView(self)
 
     def __setitem__(self, key, value):
-        try:
-            if key not in self._map:
-                self._sortedkeys.add(key)
-            self._map[key] = value
-        except:
-            if key not in self._map:
-                self._sortedkeys.discard(key)
-            raise
+        if self._map is not None:
+            try:
+                if key not in self._map:
+                    self._sortedkeys.add(key)
+                self._map[key] = value
+            except:
+                if key not in self._map:
+                    self._sortedkeys.discard(key)
+                raise
+            return
+        i = self._locate(key)
+        if i >= 0:
+            self._values[i] = value
+            return
+        keys = self._sortedkeys
+        i = keys._blist._insort(keys._u2i(key), keys._key is not None)
+        self._values.insert(i, value)
 
     def __delitem__(self, key):
-        self._sortedkeys.discard(key)
-        del self._map[key]
+        if self._map is not None:
+            self._sortedkeys.discard(key)
+            del self._map[key]
+            return
+        i = self._locate(key)
+        if i < 0:
+            raise KeyError(key)
+        del self._sortedkeys._blist[i]
+        del self._values[i]
 
     def __getitem__(self, key):
-        return self._map[key]
+        if self._map is not None:
+            return self._map[key]
+        i = self._locate(key)
+        if i < 0:
+            if hasattr(self, '__missing__'):
+                return self.__missing__(key)
+            raise KeyError(key)
+        return self._values[i]
+
+    def __contains__(self, key):
+        if self._map is not None:
+            return key in self._map
+        return self._locate(key) >= 0
 
     def __iter__(self):
         return iter(self._sortedkeys)
@@ -121,8 +209,25 @@ class sorteddict(collections.MutableMapping):
     def __len__(self):
         return len(self._sortedkeys)
 
+    def clear(self):
+        self._sortedkeys.clear()
+        if self._map is None:
+            del self._values[:]
+        else:
+            self._map.clear()
+
     def copy(self):
-        return sorteddict(self)
+        # The sorted keys and values are copied as they are, sharing
+        # nodes, so keys need not be hashable without the hash index.
+        rv = sorteddict.__new__(sorteddict)
+        rv._sortedkeys = self._sortedkeys.copy()
+        if self._map is None:
+            rv._values = blist(self._values)
+            rv._map = None
+        else:
+            rv._values = None
+            rv._map = dict(self._map)
+        return rv
 
     @classmethod
     def fromkeys(cls, keys, value=None, key=None):
@@ -139,9 +244,19 @@ class sorteddict(collections.MutableMapping):
             if r:
               return 'sorteddict({...})'
             return ('sorteddict({%s})' %
-                    ', '.join('%r: %r' % (k, self._map[k]) for k in self))
+                    ', '.join('%r: %r' % item
+                              for item in izip(self._sortedkeys,
+                                               self._itervalues())))
 
     def __eq__(self, other):
         if not isinstance(other, sorteddict):
             return False
-        return self._map == other._map
+        if self._map is not None and other._map is not None:
+            return self._map == other._map
+        if len(self) != len(other):
+            return False
+        for key, value in izip(self._sortedkeys, self._itervalues()):
+            i = other._locate(key)
+            if i < 0 or other._value_at(i) != value:
+                return False
+        return True
@@ -2,8 +2,16 @@ from blist._blist import blist
 import collections, bisect, weakref, operator, itertools, sys, threading
 try: # pragma: no cover
     izip = itertools.izip
+    imap = itertools.imap
 except AttributeError: # pragma: no cover
     izip = zip
+    imap = map
+
+_first = operator.itemgetter(0)
+
+def _func(method):
+    # The function behind a method (unbound methods wrap it in Python 2)
+    return getattr(method, '__func__', method)
 
 __all__ = ['sortedlist', 'weaksortedlist', 'sortedset', 'weaksortedset']
 
@@ -36,8 +44,11 @@ class _sortedbase(collections.Sequence):
             self._blist = blist(iterable._blist)
         else:
             self._blist = blist()
-            for v in iterable:
-                self.add(v)
+            self._add_all(iterable)
+
+    def _add_all(self, iterable):
+        for v in iterable:
+            self.add(v)
 
     def _from_iterable(self, iterable):
         return self.__class__(iterable, self._key)
@@ -82,13 +93,7 @@ class _sortedbase(collections.Sequence):
         """
 
         key = self._u2key(v)
-        lo = 0
-        hi = len(self._blist)
-        while lo < hi:
-            mid = (lo+hi)//2
-            v = self._i2key(self._blist[mid])
-            if v < key: lo = mid + 1
-            else: hi = mid
+        lo = self._blist._bisect_left(key, self._key is not None)
         if lo < len(self._blist):
             return lo, self._i2u(self._blist[lo])
         return lo, None
@@ -97,13 +102,7 @@ class _sortedbase(collections.Sequence):
         """Same as _bisect_left, but go to the right of equal values"""
 
         key = self._u2key(v)
-        lo = 0
-        hi = len(self._blist)
-        while lo < hi:
-            mid = (lo+hi)//2
-            v = self._i2key(self._blist[mid])
-            if key < v: hi = mid
-            else: lo = mid + 1
+        lo = self._blist._bisect_right(key, self._key is not None)
         if lo < len(self._blist):
             return lo, self._i2u(self._blist[lo])
         return lo, None
@@ -134,8 +133,7 @@ class _sortedbase(collections.Sequence):
         """Add an element."""
         # Will throw a TypeError when trying to add an object that
         # cannot be compared to objects already in the list.
-        i, _ = self._bisect_right(value)
-        self._blist.insert(i, self._u2i(value))
+        self._blist._insort(self._u2i(value), self._key is not None)
 
     def discard(self, value):
         """Remove an element if it is a member.
@@ -284,6 +282,11 @@ class _weaksortedbase(_sortedbase):
 
     _bisect = _bisect_right
 
+    def add(self, value):
+        """Add an element."""
+        i, _ = self._bisect_right(value)
+        self._blist.insert(i, self._u2i(value))
+
     def _u2i(self, value):
         if self._key is None:
             return weakref.ref(value)
@@ -564,6 +567,33 @@ class sortedlist(_sortedbase, _listmixin):
             if r: return 'sortedlist(...)'
             return ('sortedlist(%s)' % repr(list(self)))
 
+    def update(self, iterable):
+        """L.update(iterable) -- add all elements from iterable into the list"""
+
+        values = blist(iterable)
+        if self._key is None:
+            items = values
+        else:
+            items = blist(izip(imap(self._key, values), values))
+        if len(items) * 8 < len(self._blist):
+            for item in items:
+                self._blist._insort(item, self._key is not None)
+            return
+
+        # A stable sort puts each new item after the equal items already
+        # present, just as add() does.  Keys are fetched in C.
+        items[:0] = self._blist
+        items.sort(key=None if self._key is None else _first)
+        self._blist[:] = items
+
+    def _add_all(self, iterable):
+        # Merge in bulk only if add() has not been overridden, so that a
+        # subclass's add() still sees every item at construction.
+        if _func(type(self).add) is _func(sortedlist.add):
+            self.update(iterable)
+        else:
+            _sortedbase._add_all(self, iterable)
+
     def _cmp_op(self, other, op):
         if not (isinstance(other,type(self)) or isinstance(self,type(other))):
             return NotImplemented
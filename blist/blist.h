@@ -72,6 +72,9 @@ typedef struct PyBList {
         int num_children;     /* Number of immediate children */
         int leaf;                  /* Boolean value */
         PyObject **children;       /* Immediate children */
+        Py_ssize_t *sizes;         /* ->n of each child, or NULL */
+        int sizes_valid;           /* Boolean: sizes is up to date */
+        int sizes_allocated;       /* Room in sizes */
 } PyBList;
 
 typedef struct PyBListRoot {
@@ -81,6 +84,10 @@ typedef struct PyBListRoot {
         int num_children;     /* Number of immediate children */
         int leaf;                  /* Boolean value */
         PyObject **children;       /* Immediate children */
+        Py_ssize_t *sizes;         /* ->n of each child, or NULL */
+        int sizes_valid;           /* Boolean: sizes is up to date */
+        int sizes_allocated;       /* Room in sizes */
+        int allocated;             /* Room in children; LIMIT if !leaf */
 
         PyBList **index_list;
         Py_ssize_t *offset_list;
@@ -91,6 +98,18 @@ typedef struct PyBListRoot {
         Py_ssize_t dirty_root;
         Py_ssize_t free_root;
 
+        Py_ssize_t index_build;    /* Index misses before indexing; <0: never */
+        Py_ssize_t index_drop;     /* Idle events before dropping; 0: never */
+        Py_ssize_t index_reads;    /* Misses counted toward index_build */
+        Py_ssize_t index_idle;     /* Idle events since the last miss */
+
+        PyBList *finger;           /* Leaf of the last slow access, or NULL */
+        Py_ssize_t finger_offset;  /* Position of finger's first item */
+        int finger_rw;             /* Boolean: finger may be written to */
+        Py_ssize_t generation;     /* Advances whenever nodes may have moved */
+
+        Py_ssize_t sorted_n;       /* # of leading items known to be sorted */
+
 #ifdef Py_DEBUG
         Py_ssize_t last_n;                 /* For debug */
 #endif
@@ -144,15 +163,31 @@ PyAPI_FUNC(void) _PyList_SetItemFast(PyObject *, Py_ssize_t, PyObject *);
 #define PyList_IS_LEAF(op) ({ assert(PyList_Check(op)); (((PyBList *) (op))->leaf); })
 
 PyAPI_FUNC(PyObject *) _PyBList_GetItemFast3(PyBListRoot *, Py_ssize_t);
+PyAPI_FUNC(Py_ssize_t) _PyBList_GetChunk(PyBListRoot *, Py_ssize_t, PyObject ***);
 
 PyAPI_FUNC(PyObject *) blist_ass_item_return_slow(PyBListRoot *root, Py_ssize_t i, PyObject *v);
 PyAPI_FUNC(PyObject *) ext_make_clean_set(PyBListRoot *root, Py_ssize_t i, PyObject *v);
 #else
 PyObject *_PyBList_GetItemFast3(PyBListRoot *, Py_ssize_t);
+Py_ssize_t _PyBList_GetChunk(PyBListRoot *, Py_ssize_t, PyObject ***);
 PyObject *blist_ass_item_return_slow(PyBListRoot *root, Py_ssize_t i, PyObject *v);
 PyObject *ext_make_clean_set(PyBListRoot *root, Py_ssize_t i, PyObject *v);
 #endif
 
+/* Other extension modules cannot link against _blist, so it exports its
+ * C API as a capsule:
+ *
+ *      PyBList_CAPI *api = PyCapsule_Import(PyBList_CAPSULE_NAME, 0);
+ *      if (PyObject_TypeCheck(ob, api->RootType))
+ *              n = api->GetChunk((PyBListRoot *) ob, i, &items);
+ */
+#define PyBList_CAPSULE_NAME "blist._blist._C_API"
+
+typedef struct PyBList_CAPI {
+        PyTypeObject *RootType;    /* blist.blist */
+        Py_ssize_t (*GetChunk)(PyBListRoot *, Py_ssize_t, PyObject ***);
+} PyBList_CAPI;
+
 #define INDEX_FACTOR (HALF)
 
 /* This should only be called if we know the root is not a leaf */
@@ -65,6 +65,16 @@ class sorteddict_test(mapping_tests.TestHashMappingProtocol):
     def test_mutatingiteration(self):
         pass
 
+    # Without a hash index, looking up a key never hashes it
+    def test_getitem(self):
+        mapping_tests.TestMappingProtocol.test_getitem(self)
+
+    def test_pop(self):
+        mapping_tests.TestMappingProtocol.test_pop(self)
+
+    def test_setdefault(self):
+        mapping_tests.TestMappingProtocol.test_setdefault(self)
+
     def test_sort(self):
         u = self.type2test.fromkeys([1, 0])
         self.assertEqual(list(u.keys()), [0, 1])
@@ -158,3 +168,83 @@ class sorteddict_test(mapping_tests.TestHashMappingProtocol):
       self.assertEqual(items.count((object(), object())), 0)
       self.assertRaises(ValueError, items.index, (7, "foo"))
       self.assertRaises(ValueError, items.index, (object(), object()))
+
+    def test_hash_index(self):
+      import random
+      u = blist.sorteddict()
+      self.assertFalse(u.hash_index)
+      d = {}
+      for hash_index in (False, True, False):
+        u.hash_index = hash_index
+        self.assertEqual(u.hash_index, hash_index)
+        self.assertEqual(list(u.items()), sorted(d.items()))
+        for i in range(3000):
+          k = random.randrange(500)
+          if random.random() < 0.3 and k in d:
+            del u[k]
+            del d[k]
+          else:
+            u[k] = d[k] = i
+        self.assertEqual(len(u), len(d))
+        self.assertEqual(list(u.items()), sorted(d.items()))
+        self.assertEqual(list(u.values()), [d[k] for k in sorted(d)])
+        self.assertEqual(u.values()[3:9], [d[k] for k in sorted(d)[3:9]])
+        self.assertEqual(u.items()[-1], max(d.items()))
+        for k in range(-1, 501):
+          self.assertEqual(k in u, k in d)
+          self.assertEqual(u.get(k), d.get(k))
+        self.assertRaises(KeyError, u.__getitem__, 'x')
+        self.assertRaises(KeyError, u.__delitem__, 'x')
+        self.assertEqual(u, blist.sorteddict(d))
+        v = u.copy()
+        self.assertEqual(v.hash_index, hash_index)
+        v[-1] = None
+        self.assertEqual(v[-1], None)
+        self.assertFalse(-1 in u)
+
+      # Without the hash index, keys need not be hashable
+      u = blist.sorteddict()
+      u[[2]] = 'b'
+      u[[1]] = 'a'
+      self.assertEqual(list(u.items()), [([1], 'a'), ([2], 'b')])
+      self.assertEqual(u[[2]], 'b')
+      del u[[1]]
+      self.assertEqual(list(u.keys()), [[2]])
+      v = u.copy()
+      self.assertFalse(v.hash_index)
+      v[[0]] = 'c'
+      self.assertEqual(list(v.items()), [([0], 'c'), ([2], 'b')])
+      self.assertEqual(list(u.items()), [([2], 'b')])
+      self.assertRaises(TypeError, setattr, u, 'hash_index', True)
+      self.assertFalse(u.hash_index)
+
+      u = blist.sorteddict(lambda x: -x, {1: 'a', 2: 'b'})
+      u.hash_index = True
+      v = u.copy()
+      self.assertTrue(v.hash_index)
+      v[3] = 'c'
+      del v[1]
+      self.assertEqual(list(v.items()), [(3, 'c'), (2, 'b')])
+      self.assertEqual(list(u.items()), [(2, 'b'), (1, 'a')])
+      self.assertEqual(v[2], 'b')
+      self.assertFalse(1 in v)
+
+class hashed_sorteddict(blist.sorteddict):
+    def __init__(self, *args, **kw):
+        blist.sorteddict.__init__(self, *args, **kw)
+        self.hash_index = True
+
+class sorteddict_hash_index_test(sorteddict_test):
+    type2test = hashed_sorteddict
+
+    test_getitem = mapping_tests.TestHashMappingProtocol.test_getitem
+    test_pop = mapping_tests.TestHashMappingProtocol.test_pop
+    test_setdefault = mapping_tests.TestHashMappingProtocol.test_setdefault
+
+    # copy() returns a plain sorteddict, so check that it keeps the index
+    def test_copy(self):
+        d = self._full_mapping({1:1, 2:2, 3:3})
+        c = d.copy()
+        self.assertEqual(c, self._full_mapping({1:1, 2:2, 3:3}))
+        self.assert_(c.hash_index)
+        self.assertRaises(TypeError, d.copy, None)
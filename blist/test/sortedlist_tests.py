@@ -1,7 +1,7 @@
 # This file based loosely on Python's list_tests.py.
 
 import sys
-import collections, operator
+import collections, operator, bisect
 import gc
 import random
 import blist
@@ -302,6 +302,19 @@ class StrongSortedBase(SortedBase, seq_tests.CommonTest):
             self.assertRaises(ZeroDivisionError, self.type2test,
                               seq_tests.IterGenExc(s))
 
+    def test_bisect_large(self):
+        values = [random.randrange(500) for i in range(3000)]
+        for key in (None, lambda x: -x):
+            u = self.type2test(values, key=key)
+            keys = [x if key is None else key(x) for x in u]
+            self.assertEqual(keys, sorted(keys))
+            for v in range(-1, 501):
+                k = v if key is None else key(v)
+                self.assertEqual(u.bisect_left(v), bisect.bisect_left(keys, k))
+                self.assertEqual(u.bisect_right(v),
+                                 bisect.bisect_right(keys, k))
+                self.assertEqual(v in u, v in values)
+
 class weak_int:
     def __init__(self, v):
         self.value = v
@@ -593,6 +606,29 @@ class SortedSetMixin:
 class SortedListTest(StrongSortedBase, SortedListMixin):
     type2test = blist.sortedlist
 
+    def test_update_stable(self):
+        values = [(random.randrange(20), i) for i in range(500)]
+        for key in (operator.itemgetter(0), lambda x: -x[0]):
+            expected = self.type2test(key=key)
+            for v in values:
+                expected.add(v)
+            u = self.type2test(values[:250], key=key)
+            u.update(values[250:])
+            self.assertEqual(list(u), list(expected))
+            u.update(values[:10])
+            for v in values[:10]:
+                expected.add(v)
+            self.assertEqual(list(u), list(expected))
+
+    def test_subclass_add(self):
+        class NonNegative(self.type2test):
+            def add(self, value):
+                if value < 0:
+                    raise ValueError(value)
+                super(NonNegative, self).add(value)
+        self.assertRaises(ValueError, NonNegative, [3, -1, 2])
+        self.assertEqual(list(NonNegative([3, 1, 2])), [1, 2, 3])
+
 class WeakSortedListTest(WeakSortedBase, SortedListMixin):
     type2test = blist.weaksortedlist
 
@@ -1,5 +1,6 @@
 #!/usr/bin/env python
 
+import os
 import re
 import sys
 import ez_setup
@@ -16,6 +17,11 @@ if ctypes.sizeof(ctypes.c_double) == 8:
     if iv.contents.value == 0x433fff0102030405:
         define_macros.append(('BLIST_FLOAT_RADIX_SORT', 1))
 
+# The node size is fixed when blist is built.  Larger nodes favor
+# scanning and indexing; smaller ones favor inserting and deleting.
+if os.environ.get('BLIST_LIMIT'):
+    define_macros.append(('LIMIT', int(os.environ['BLIST_LIMIT'])))
+
 with open('blist/__init__.py') as f:
   line = f.readline()
   match = re.search(r'= *[\'"](.*)[\'"]', line)
@@ -29,6 +35,7 @@ setup(name='blist',
       url='http://stutzbachenterprises.com/blist/',
       license = "BSD",
       keywords = "blist list b+tree btree fast copy-on-write sparse array sortedlist sorted sortedset weak weaksortedlist weaksortedset sorteddict btuple",
+      headers=['blist/blist.h'],
       ext_modules=[Extension('blist._blist', ['blist/_blist.c'],
                              define_macros=define_macros,
                              )],
@@ -31,11 +31,32 @@ makedir('.cache')
 makedir('dat')
 makedir('gnuplot')
 
+def read_limit():
+    # The node size of the extension built in place, if any
+    try:
+        from blist import _blist
+    except ImportError:
+        return None
+    return _blist._limit
+
 limits = (128,)
 current_limit = None
+built_limit = read_limit()
+default_limit = built_limit
 def make(limit):
-    global current_limit
+    # A limit of None rebuilds with the default node size
+    global current_limit, built_limit
     current_limit = limit
+    if limit == 'list' or limit == built_limit:
+        return
+    env = dict(os.environ)
+    if limit is None:
+        env.pop('BLIST_LIMIT', None)
+    else:
+        env['BLIST_LIMIT'] = str(limit)
+    subprocess.check_call([sys.executable, 'setup.py', 'build_ext',
+                           '--inplace', '--force'], env=env)
+    built_limit = limit
 
 setup = 'from blist import blist'
 
@@ -309,6 +330,8 @@ add_timing('sort sorted key', None, 'x.sort(key=int)')
 add_timing('sort reversed', 'x = list(range(n))\nx.reverse()', 'y = TypeToTest(x)\ny.sort()')
 add_timing('sort reversed key', 'x = list(range(n))\nx.reverse()', 'y = TypeToTest(x)\ny.sort(key=int)')
 
+add_timing('sort random strings', 'import random\nx = ["id_%d" % random.randrange(n*4) for i in range(n)]', 'y = TypeToTest(x)\ny.sort()')
+
 add_timing('sort random tuples', 'import random\nx = [(random.random(), random.random()) for i in range(n)]', 'y = TypeToTest(x)\ny.sort()')
 
 ob_def = '''
@@ -324,6 +347,20 @@ x = [ob(random.randrange(n*4)) for i in range(n)]
 add_timing('sort random objects', ob_def, 'y = TypeToTest(x)\ny.sort()')
 add_timing('sort sorted objects', ob_def + 'x.sort()', 'x.sort()')
 
+# Items scattered in memory relative to their order in the list, as
+# after a shuffle; scans over these are bound by cache misses once n
+# outgrows the cache (try MAX_X = 10**7).
+shuffled_def = '''
+import random
+x = [float(i) for i in range(n)]
+random.shuffle(x)
+x = TypeToTest(x)
+'''
+
+add_timing('count shuffled', shuffled_def, 'x.count(-1.0)')
+add_timing('contains shuffled', shuffled_def, '-1.0 in x')
+add_timing('forloop shuffled', shuffled_def, 'for i in x:\n    pass')
+
 add_timing('init from list', 'x = list(range(n))', 'y = TypeToTest(x)')
 add_timing('init from tuple', 'x = tuple(range(n))', 'y = TypeToTest(x)')
 add_timing('init from iterable', 'x = range(n)', 'y = TypeToTest(x)')
@@ -332,9 +369,13 @@ add_timing('init from same type', None, 'y = TypeToTest(x)')
 add_timing('shuffle', 'from random import shuffle\nx = TypeToTest(range(n))', 'shuffle(x)')
 
 if __name__ == '__main__':
-    make(128)
-    if len(sys.argv) == 1:
-        run_all()
-    else:
-        for name in sys.argv[1:]:
-            run_timing(name)
+    try:
+        make(128)
+        if len(sys.argv) == 1:
+            run_all()
+        else:
+            for name in sys.argv[1:]:
+                run_timing(name)
+    finally:
+        # Leave the in-place build at the node size we found it with
+        make(default_limit)
@@ -346,13 +346,576 @@ class BListTest(list_tests.CommonTest):
         x = blist.blist([0.1, 0.2, 0.3])
         x.sort()
 
+    def sort_strings_test(self, x, k):
+        y = blist.blist(x)
+        y.sort()
+        self.assertEqual(y, sorted(x))
+        y = blist.blist(x)
+        y.sort(key=lambda s: s[:k]) # stability
+        self.assertEqual(y, sorted(x, key=lambda s: s[:k]))
+        y = blist.blist(x)
+        y.sort(reverse=True)
+        self.assertEqual(y, sorted(x, reverse=True))
+
+    def test_sort_strings(self):
+        import random
+        r = random.Random(7)
+        def word(alphabet):
+            return ''.join(r.choice(alphabet)
+                           for i in range(r.randrange(12)))
+        for alphabet in ['ab\x00', 'ab\xff', 'a\u0100\u3000',
+                         'a\U00010000\U0010ffff']:
+            prefix = r.choice(['', 'identifier_', 'x' * 30])
+            x = [prefix + word(alphabet) for i in range(2000)]
+            self.sort_strings_test(x, len(prefix) + 2)
+            if str is not bytes:
+                x = [s.encode('utf-8') for s in x]
+                self.sort_strings_test(x, len(prefix) + 2)
+
+    def sort_numbers_test(self, x):
+        y = blist.blist(x)
+        y.sort()
+        self.assertEqual(list(map(repr, y)), list(map(repr, sorted(x))))
+        y = blist.blist(x)
+        y.sort(reverse=True)
+        self.assertEqual(list(map(repr, y)),
+                         list(map(repr, sorted(x, reverse=True))))
+
+    def test_sort_big_ints(self):
+        import random
+        r = random.Random(11)
+        for bits in [40, 70, 127, 200]:
+            x = [r.randrange(-2**bits, 2**bits) for i in range(1000)]
+            x += [2**63, -2**63, 2**64, -2**64-1, 2**127-1, -2**127, 0, -1]
+            x += x[:100]
+            self.sort_numbers_test(x)
+
+    def test_sort_mixed_numbers(self):
+        import random
+        r = random.Random(13)
+        x = [r.choice([r.randrange(-1000, 1000), r.random() * 2000 - 1000])
+             for i in range(1000)]
+        x += [0, 0.0, -0.0, 0, -0.0, 2**53, 2.0**53, 2**60, 2.0**60, 2**200,
+              2.0**200, float('inf'), -float('inf'), 5, 5.0, 5]
+        r.shuffle(x)
+        self.sort_numbers_test(x)
+        self.sort_numbers_test(x + [2**53+1])
+        self.sort_numbers_test(x + [2**64+1])
+        self.sort_numbers_test([0.0, -0.0] * 20)
+        self.sort_numbers_test([0.0, -0.0] * 20 + [0] * 20)
+
+    def test_sort_tuples(self):
+        import random
+        r = random.Random(17)
+        fields = [lambda: r.randrange(-3, 3),
+                  lambda: r.choice([1.5, -0.0, 0.0, 2, -1]),
+                  lambda: r.choice(['', 'a', 'ab', 'b', 'abcdefghij']),
+                  lambda: r.choice([2**70, -2**70, 0, 1]),
+                  lambda: r.random()]
+        for arity in range(4):
+            for i in range(10):
+                columns = [r.choice(fields) for j in range(arity)]
+                x = [tuple(f() for f in columns) for k in range(300)]
+                self.sort_numbers_test(x)
+        x = [(r.randrange(3), r.randrange(3)) for k in range(300)]
+        self.sort_numbers_test(x + [(1,)])
+        self.sort_numbers_test(x + [(1, 0.5), (1, 2**60 + 1)])
+        self.sort_numbers_test(x + [(1, float('nan'))])
+        if str is not bytes:
+            y = blist.blist(x + [(1, 'a')])
+            self.assertRaises(TypeError, y.sort)
+
+    def test_sort_getters(self):
+        class Point(object):
+            def __init__(self, x, y):
+                self.x, self.y = x, y
+                self.me = self
+        class Seq(object):
+            def __getitem__(self, i):
+                return -i
+        rows = [(i % 7, -i, str(i)) for i in range(200)]
+        getters = [operator.itemgetter(0), operator.itemgetter(-1),
+                   operator.itemgetter(1, 0), operator.itemgetter(slice(1))]
+        for key in getters:
+            for data in (rows, [list(r) for r in rows]):
+                x = blist.blist(data)
+                x.sort(key=key)
+                self.assertEqual(x, sorted(data, key=key))
+        dicts = [{'a': i % 5, 'b': -i} for i in range(200)]
+        x = blist.blist(dicts)
+        x.sort(key=operator.itemgetter('a', 'b'))
+        self.assertEqual(x, sorted(dicts, key=operator.itemgetter('a', 'b')))
+        x = blist.blist([Seq()] * 3)
+        x.sort(key=operator.itemgetter(2))
+        points = [Point(i % 3, -i) for i in range(200)]
+        for key in (operator.attrgetter('x'), operator.attrgetter('x', 'y'),
+                    operator.attrgetter('me.me.y')):
+            x = blist.blist(points)
+            x.sort(key=key)
+            self.assertEqual(x, sorted(points, key=key))
+        x = blist.blist(rows)
+        self.assertRaises(IndexError, x.sort, key=operator.itemgetter(3))
+        self.assertEqual(x, rows)
+        x = blist.blist(dicts)
+        self.assertRaises(KeyError, x.sort, key=operator.itemgetter('c'))
+        x = blist.blist(points)
+        self.assertRaises(AttributeError, x.sort,
+                          key=operator.attrgetter('x.z'))
+
+    def test_argsort(self):
+        import random
+        r = random.Random(19)
+        for n in (0, 1, 5, limit+1, 3000):
+            x = [r.randrange(n // 3 + 1) for i in range(n)]
+            for data in (x, [str(v) for v in x], [(v, -v) for v in x]):
+                y = blist.blist(data)
+                for reverse in (False, True):
+                    expected = sorted(range(n), key=data.__getitem__,
+                                      reverse=reverse)
+                    self.assertEqual(y.argsort(reverse=reverse), expected)
+                self.assertEqual(y, data)
+            y = blist.blist(x)
+            self.assertEqual(y.argsort(key=lambda v: -v),
+                             sorted(range(n), key=lambda i: -x[i]))
+
+        y = blist.blist(range(100))
+        def mutate(v):
+            del y[:]
+            return -v
+        self.assertEqual(y.argsort(key=mutate), list(range(99, -1, -1)))
+        y = blist.blist(range(100))
+        self.assertRaises(ZeroDivisionError, y.argsort, key=lambda v: 1 // v)
+        self.assertEqual(y, list(range(100)))
+
+    def test_select(self):
+        import random
+        r = random.Random(23)
+        for n in (0, 1, 5, limit+1, 3000):
+            x = [r.randrange(n // 3 + 1) for i in range(n)]
+            for data in (x, [str(v) for v in x], [(v, -v) for v in x]):
+                y = blist.blist(data)
+                for k in (-1, 0, 1, 2, n // 2, n - 1, n, n + 5):
+                    self.assertEqual(y.nsmallest(k), sorted(data)[:max(k, 0)])
+                    self.assertEqual(y.nlargest(k),
+                                     sorted(data, reverse=True)[:max(k, 0)])
+                    if -n <= k < n:
+                        self.assertEqual(y.select(k), sorted(data)[k])
+                    else:
+                        self.assertRaises(IndexError, y.select, k)
+                self.assertEqual(y, data)
+
+            # Ties keep their original order
+            y = blist.blist(range(n))
+            for k in (1, n // 2, n):
+                self.assertEqual(y.nsmallest(k, key=lambda v: v % 3),
+                                 sorted(y, key=lambda v: v % 3)[:k])
+                self.assertEqual(y.nlargest(k, key=lambda v: v % 3),
+                                 sorted(y, key=lambda v: v % 3,
+                                        reverse=True)[:k])
+            if n:
+                self.assertEqual(y.select(n // 2, key=lambda v: -v),
+                                 n - 1 - n // 2)
+
+        y = blist.blist(range(100))
+        def mutate(v):
+            del y[:]
+            return -v
+        self.assertEqual(y.nsmallest(3, key=mutate), [99, 98, 97])
+        y = blist.blist(range(100))
+        self.assertRaises(ZeroDivisionError, y.nlargest, 5,
+                          key=lambda v: 1 // v)
+        class Bad(object):
+            def __lt__(self, other):
+                raise ZeroDivisionError
+        y = blist.blist([Bad() for i in range(10)])
+        self.assertRaises(ZeroDivisionError, y.select, 2)
+
+    def test_sort_appended(self):
+        import random
+        r = random.Random(29)
+        def ops(L, v):
+            i = r.randrange(len(L) or 1)
+            j = r.randrange(len(L) or 1)
+            return [lambda: L.append(v),
+                    lambda: L.extend([v, v]),
+                    lambda: L.__setitem__(i, v),
+                    lambda: L.insert(i, v),
+                    lambda: L.__delitem__(i),
+                    lambda: L.pop(),
+                    lambda: L.pop(i),
+                    lambda: L.remove(L[i]),
+                    lambda: L.reverse(),
+                    lambda: L.__setitem__(slice(i, j), [v, v]),
+                    lambda: L.__setitem__(slice(i, None, -3),
+                                          [v] * len(L[i::-3])),
+                    lambda: L.__delitem__(slice(j, None, 5)),
+                    lambda: L.__imul__(2)]
+        for n in (limit+1, 3000):
+            for f in (int, float, str, lambda v: v << 70):
+                x = [f(r.randrange(n)) for i in range(n)]
+                y = blist.blist(x)
+                x.sort()
+                y.sort()
+                for trial in range(40):
+                    for k in range(r.randrange(1, 4)):
+                        v = f(r.randrange(-n, 2*n))
+                        op = r.randrange(13) if x else 0
+                        state = r.getstate()
+                        ops(x, v)[op]()
+                        r.setstate(state)
+                        ops(y, v)[op]()
+                    if len(x) > 4 * n:
+                        del x[n:]
+                        del y[n:]
+                    x.sort()
+                    y.sort()
+                    self.assertEqual(y, x)
+
+            # Equal items keep their order
+            x = [r.randrange(n) for i in range(n)]
+            y = blist.blist(x)
+            x.sort()
+            y.sort()
+            for v in range(n // 10):
+                x.append(float(r.randrange(n)))
+                y.append(x[-1])
+            x.sort()
+            y.sort()
+            self.assertEqual(list(map(repr, y)), list(map(repr, x)))
+
+            # Items that may change in place are not tracked
+            y = blist.blist([i] for i in range(n))
+            y.sort()
+            y[0][0] = n
+            y.append([0])
+            y.sort()
+            self.assertEqual(y, sorted([i] for i in range(n+1)))
+
+            class Bad(object):
+                def __lt__(self, other):
+                    raise ZeroDivisionError
+                __gt__ = __lt__
+            y = blist.blist(range(n))
+            y.sort()
+            bad = Bad()
+            y.append(bad)
+            self.assertRaises(ZeroDivisionError, y.sort)
+            self.assertEqual(len(y), n + 1)
+            self.assertTrue(any(v is bad for v in y))
+
+    def test_cache_limits(self):
+        old = _blist.set_cache_limits(nodes=1000, slabs=0)
+        try:
+            self.assertEqual(_blist.set_cache_limits(), (1000, 0))
+            x = blist.blist(range(100000))
+            y = blist.blist(x)
+            y.reverse()
+            del x, y
+            _blist.release_memory()
+            x = blist.blist(range(100000))
+            x.reverse()
+            self.assertEqual(x, list(range(99999, -1, -1)))
+            self.assertRaises(ValueError, _blist.set_cache_limits, -1)
+        finally:
+            _blist.set_cache_limits(*old)
+        self.assertEqual(_blist.set_cache_limits(), old)
+
+    def test_index_policy(self):
+        n = 10000
+        x = blist.blist(range(n))
+        self.assertEqual(x.set_index_policy(build=4, drop=100), (16, 1024))
+        self.assertEqual(x.set_index_policy(), (4, 100))
+        for i in range(4):
+            self.assertEqual(x[i * 37], i * 37)
+        small = sys.getsizeof(x)
+        for i in range(1000):
+            self.assertEqual(x[i * 7 % n], i * 7 % n)
+        self.assertTrue(sys.getsizeof(x) > small)
+        for i in range(100):
+            x.insert(i, -i)
+            del x[i]
+        self.assertEqual(sys.getsizeof(x), small)
+        self.assertEqual(x, list(range(n)))
+
+        for build in (-1, 0):
+            x = blist.blist(range(n))
+            x.set_index_policy(build, 0)
+            y = list(range(n))
+            for i in range(2000):
+                j = i * 31 % n
+                x[j] = y[j] = -i
+                x.insert(j, i)
+                y.insert(j, i)
+                self.assertEqual(x[j * 3 % len(x)], y[j * 3 % len(y)])
+            self.assertEqual(x, y)
+            x.reverse()
+            y.reverse()
+            self.assertEqual(x, y)
+        self.assertRaises(ValueError, x.set_index_policy, -2)
+
+    def test_sequential_after_change(self):
+        n = 10000
+        for build in (-1, 16):
+            x = blist.blist(range(n))
+            x.set_index_policy(build, 0)
+            y = list(range(n))
+            for k in range(20):
+                j = k * 479 % n
+                x.insert(j, k)
+                y.insert(j, k)
+                z = x[:]
+                w = y[:j] + y[j + 1:]
+                for i in range(j, min(j + 300, n)):
+                    x[i] = y[i] = x[i] + 1
+                for i in range(j - 1, max(j - 300, -1), -1):
+                    self.assertEqual(x[i], y[i])
+                    x[i] = y[i] = -i
+                del y[j]
+                self.assertEqual(z.pop(j), k)
+                self.assertEqual(z, w)
+                del x[j]
+            self.assertEqual(x, y)
+
+    def test_iter_indexed(self):
+        n = 20000
+        x = blist.blist(range(n))
+        x.set_index_policy(0, 0)
+        for i in range(0, n, 7):
+            self.assertEqual(x[i], i)
+        y = list(x)
+        self.assertEqual(y, list(range(n)))
+        self.assertEqual(list(reversed(x)), y[::-1])
+        self.assertEqual(x.index(n - 5, 300), n - 5)
+        self.assertEqual(x.count(n // 2), 1)
+        it = iter(x)
+        rit = reversed(x)
+        for k in range(1000):
+            next(it)
+            next(rit)
+        self.assertEqual(it.__length_hint__(), n - 1000)
+        self.assertEqual(rit.__length_hint__(), n - 1000)
+
+        # Changing the list during iteration gives unspecified items,
+        # but must not crash
+        for k, v in enumerate(it):
+            if k % 1000 == 0:
+                del x[n // 2:]
+                x.extend(range(k))
+                x[k % len(x)]
+        for k, v in enumerate(rit):
+            if k % 1000 == 0:
+                del x[:len(x) // 3]
+                x[k % len(x)]
+
+    def test_cursor(self):
+        n = 10000
+        x = blist.blist(range(n))
+        y = list(range(n))
+        c = x.cursor(-10)
+        self.assertEqual(c.index, n - 10)
+        self.assertEqual(c.get(), n - 10)
+        self.assertRaises(IndexError, x.cursor, n + 1)
+        c.seek(n)
+        self.assertRaises(IndexError, c.get)
+        self.assertRaises(IndexError, c.next)
+        c.seek(0)
+        self.assertRaises(IndexError, c.prev)
+
+        other = x.cursor(5000)
+        i = 1000
+        c.seek(i)
+        for k in range(3000):
+            c.insert(-k)
+            y.insert(i, -k)
+            i += 1
+            if k % 3 == 0:
+                c.delete()
+                del y[i]
+            if k % 5 == 0:
+                c.prev()
+                i -= 1
+            self.assertEqual(c.get(), y[i])
+            c.set(k)
+            y[i] = k
+            c.next()
+            i += 1
+            if k % 100 == 0:
+                x.insert(k, k)
+                y.insert(k, k)
+                z = x[:]
+                w = y[:]
+                self.assertEqual(other.get(), y[5000])
+        self.assertEqual(c.index, i)
+        self.assertEqual(x, y)
+        self.assertEqual(z, w)
+
+        del x[10:]
+        del y[10:]
+        self.assertEqual(other.index, 10)
+        other.prev()
+        other.delete()
+        del y[9]
+        self.assertEqual(x, y)
+
+    def test_deque_ops(self):
+        import collections
+        for n in (0, 5, 1000, 10000):
+            x = blist.blist(range(n))
+            y = collections.deque(range(n))
+            for k in range(3000):
+                if k % 3 == 0:
+                    x.appendleft(k)
+                    y.appendleft(k)
+                elif y:
+                    self.assertEqual(x.popleft(), y.popleft())
+                x.append(-k)
+                y.append(-k)
+                if k % 500 == 0:
+                    z = x[:]
+                    w = list(y)
+                    x.rotate(k * 7 + 3)
+                    y.rotate(k * 7 + 3)
+                    x.rotate(-k)
+                    y.rotate(-k)
+                    x.extendleft(range(k % 300))
+                    y.extendleft(range(k % 300))
+                    self.assertEqual(x, list(y))
+                    self.assertEqual(z, w)
+            self.assertEqual(x, list(y))
+        x = blist.blist()
+        self.assertRaises(IndexError, x.popleft)
+        x.extendleft(iter('abc'))
+        self.assertEqual(x, ['c', 'b', 'a'])
+        x.extendleft(x)
+        self.assertEqual(x, ['a', 'b', 'c', 'c', 'b', 'a'])
+        x.rotate()
+        self.assertEqual(x, ['a', 'a', 'b', 'c', 'c', 'b'])
+
+    def test_split_move(self):
+        import random
+        r = random.Random(21)
+        for n in (0, 7, 1000, 20000):
+            x = blist.blist(range(n))
+            y = list(range(n))
+            for k in range(60):
+                i = r.randint(-5, n + 5)
+                left, right = x.split(i)
+                self.assertEqual(left, y[:i])
+                self.assertEqual(right, y[i:])
+                start = r.randint(-n - 2, n + 2)
+                stop = r.randint(-n - 2, n + 2)
+                dest = r.randint(-n - 2, n + 2)
+                z = x[:]
+                w = y[:]
+                x.move(start, stop, dest)
+                a, b = slice(start, stop).indices(n)[:2]
+                d = slice(dest, None).indices(n)[0]
+                if a < b and not a <= d <= b:
+                    block = y[a:b]
+                    del y[a:b]
+                    if d > b:
+                        d -= b - a
+                    y[d:d] = block
+                self.assertEqual(x, y)
+                self.assertEqual(z, w)
+                left.append(k)
+                right.insert(0, k)
+                self.assertEqual(x, y)
+
+    def test_iter_chunks(self):
+        for n in (0, 1, limit, limit + 1, 1000, 100000):
+            x = blist.blist(range(n))
+            del x[n//3:n//3+5]
+            y = list(x)
+            chunks = list(x.iter_chunks())
+            self.assertEqual([i for t in chunks for i in t], y)
+            for t in chunks:
+                self.assertEqual(type(t), tuple)
+                self.assertTrue(0 < len(t) <= limit)
+            it = x.iter_chunks()
+            if y:
+                self.assertEqual(next(it), tuple(y[:len(chunks[0])]))
+            self.assertEqual([i for t in it for i in t],
+                             y[len(chunks[0]) if chunks else 0:])
+
+    def test_chunk_capi(self):
+        # Call GetChunk from the exported C API as another extension
+        # module would
+        if not hasattr(_blist, '_C_API'):
+            return # No capsules before Python 2.7
+        import ctypes
+        class CAPI(ctypes.Structure):
+            _fields_ = [('RootType', ctypes.c_void_p),
+                        ('GetChunk', ctypes.PYFUNCTYPE(
+                            ctypes.c_ssize_t, ctypes.py_object,
+                            ctypes.c_ssize_t,
+                            ctypes.POINTER(ctypes.POINTER(
+                                ctypes.py_object))))]
+        get_pointer = ctypes.pythonapi.PyCapsule_GetPointer
+        get_pointer.restype = ctypes.c_void_p
+        get_pointer.argtypes = [ctypes.py_object, ctypes.c_char_p]
+        api = ctypes.cast(get_pointer(_blist._C_API, b'blist._blist._C_API'),
+                          ctypes.POINTER(CAPI)).contents
+        self.assertEqual(api.RootType, id(blist.blist))
+
+        items = ctypes.POINTER(ctypes.py_object)()
+        for n in (0, 1, limit, limit + 1, 1000, 100000):
+            x = blist.blist(range(n))
+            del x[n//3:n//3+5]
+            y = []
+            i = 0
+            while i < len(x):
+                k = api.GetChunk(x, i, ctypes.byref(items))
+                self.assertTrue(0 < k <= limit)
+                y.extend(items[j] for j in range(k))
+                i += k
+            self.assertEqual(y, list(x))
+            self.assertEqual(api.GetChunk(x, len(x), ctypes.byref(items)), 0)
+            self.assertEqual(api.GetChunk(x, -1, ctypes.byref(items)), 0)
+
+    def test_partition_chunks(self):
+        for n in (0, 5, 1000, 100000):
+            x = blist.blist(range(n))
+            for k in (1, 2, 3, 7, 64):
+                pieces = x.partition_chunks(k)
+                self.assertEqual(len(pieces), k)
+                self.assertEqual([i for p in pieces for i in p],
+                                 list(range(n)))
+                for p in pieces:
+                    self.assertTrue(abs(len(p) - n // k) <= limit + 1)
+                pieces[0].append(-1)
+                self.assertEqual(x, list(range(n)))
+        self.assertRaises(ValueError, blist.blist().partition_chunks, 0)
+
+    def test_sort_parallel(self):
+        import random
+        # Lower the threshold so that small lists take the threaded path
+        old = _blist._set_parallel_sort_threshold(4096)
+        try:
+            n = 4 * 4096 + 1000
+            r = random.Random(5)
+            x = [r.randrange(-n, n) for i in range(n)]
+            y = blist.blist(x)
+            y.sort()
+            self.assertEqual(y, sorted(x))
+            y = blist.blist(x)
+            y.sort(key=lambda v: v % 1000) # stability
+            self.assertEqual(y, sorted(x, key=lambda v: v % 1000))
+            x = [r.random() for i in range(n)]
+            y = blist.blist(x)
+            y.sort(reverse=True)
+            self.assertEqual(y, sorted(x, reverse=True))
+        finally:
+            _blist._set_parallel_sort_threshold(old)
+
 tests = [BListTest,
          sortedlist_tests.SortedListTest,
          sortedlist_tests.WeakSortedListTest,
          sortedlist_tests.SortedSetTest,
          sortedlist_tests.WeakSortedSetTest,
          btuple_tests.bTupleTest,
-         sorteddict_tests.sorteddict_test
+         sorteddict_tests.sorteddict_test,
+         sorteddict_tests.sorteddict_hash_index_test
          ]
 tests += test_set.test_classes
 